@@ -0,0 +1,219 @@
+/*  Banc d'essai hôte d'endurance de l'eeprom (magasin en journal et en-tête tournant, partie 5 de main.c).
+    Chaque scénario simule JOURS jours d'utilisation avec les fonctions du programme (redémarrages, enregistrements,
+    RESET) et compte les écritures de chaque octet de l'eeprom. Un octet de l'atmega328p supporte ENDURANCE écritures :
+    l'octet le plus écrit donne la durée de vie projetée, comparée à celle de l'ancienne disposition, où le compteur
+    d'entrées était réécrit à chaque enregistrement et RESET et le compteur de démarrages à chaque démarrage. Les
+    redémarrages comptent aussi la graine de la fonction aléatoire (partie 6).
+    Le banc vérifie aussi que les entrées sont retrouvées après chaque redémarrage, et que le répertoire en SRAM tenu à
+    jour par les écritures est celui que le redémarrage relit dans l'eeprom (code de retour non nul sinon).
+    Un premier tableau donne le coût de chaque opération sur le magasin : octets demandés, octets réellement programmés
+    (écriture différentielle, voir ecriture_eeprom()) et durée des écritures sur l'horloge virtuelle (3,4 ms par octet).
+    Compilation et exécution : make bench-hote (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+#define ENDURANCE 100000    // Écritures par octet garanties par la documentation de l'atmega328p
+#define JOURS 10000
+#define APPLICATIONS_MAX MAX_ENTREES
+
+typedef struct {
+    const char *nom;
+    uint8_t fixes;              // Applications enregistrées une fois pour toutes
+    uint8_t tournantes;         // Applications réenregistrées à tour de rôle, une par jour
+    uint8_t demarrages;         // Démarrages par jour
+    uint16_t periode_reset;     // RESET (puis réenregistrement de toutes les applications) tous les n jours, 0 : jamais
+} scenario;
+
+static const scenario scenarios[] = {
+    {"usage courant", 8, 4, 2, 365},
+    {"presque plein", 14, 1, 2, 0},
+    {"magasin plein", 15, 1, 2, 0},
+    {"sans inscription", 8, 0, 10, 0},
+};
+
+static uint8_t applications[APPLICATIONS_MAX][TAILLE_APP_ID_HASH];
+static int echecs = 0;
+
+static void enregistrement(uint8_t a){
+    uint8_t private_key[TAILLE_CLE_PRIVE];
+    for(int i=0; i<TAILLE_CLE_PRIVE; i++){
+        private_key[i] = rand();
+    }
+    if(!sauvegarde_entree_eeprom(applications[a], applications[a], private_key)){
+        printf("ECHEC : enregistrement refusé\n");
+        echecs++;
+    }
+}
+
+//  Redémarrage comme dans config(), puis vérification du contenu du magasin et du répertoire en SRAM (tenu à jour à
+//  chaque écriture, il doit être identique à celui relu dans l'eeprom)
+static void redemarrage(uint8_t applications_attendues){
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID], private_key[TAILLE_CLE_PRIVE];
+    uint8_t app_id_avant[MAX_ENTREES][TAILLE_APP_ID_HASH], credential_id_avant[MAX_ENTREES][TAILLE_CREDENTIAL_ID];
+    uint16_t entrees_avant = emplacements_entrees;
+    memcpy(app_id_avant, app_id_sram, sizeof(app_id_sram));
+    memcpy(credential_id_avant, credential_id_sram, sizeof(credential_id_sram));
+    chargement_magasin();
+    initialisation_aleatoire();     // Compteur de démarrages et graine
+    for(uint8_t e=0; e<MAX_ENTREES; e++){
+        if((entrees_avant & (1u << e))
+           && (memcmp(app_id_avant[e], app_id_sram[e], TAILLE_APP_ID_HASH) != 0
+               || memcmp(credential_id_avant[e], credential_id_sram[e], TAILLE_CREDENTIAL_ID) != 0)){
+            printf("ECHEC : répertoire en SRAM différent de l'eeprom (emplacement %u)\n", e);
+            echecs++;
+        }
+    }
+    if(nombre_entrees != applications_attendues){
+        printf("ECHEC : %u entrées après redémarrage, %u attendues\n", nombre_entrees, applications_attendues);
+        echecs++;
+    }
+    for(uint8_t a=0; a<applications_attendues; a++){
+        if(!recherche_entree_eeprom(applications[a], credential_id, private_key)){
+            printf("ECHEC : application %u introuvable après redémarrage\n", a);
+            echecs++;
+        }
+    }
+}
+
+//  Nom de l'octet de l'eeprom à la position 'position'
+static void nom_octet(uint16_t position, char *nom, size_t taille){
+    uint16_t entete = hote_eeprom_position(entete_eeprom), magasin = hote_eeprom_position(magasin_eeprom);
+    uint16_t graine = hote_eeprom_position(graine_eeprom);
+    if(position >= entete && position < entete + sizeof(entete_eeprom)){
+        snprintf(nom, taille, "en-tête, cellule %u", (position - entete) / TAILLE_CELLULE);
+    }
+    else if(position >= magasin && position < magasin + sizeof(magasin_eeprom)){
+        uint16_t decalage = (position - magasin) % TAILLE_ENTREE;
+        snprintf(nom, taille, "emplacement %u, %s", (position - magasin) / TAILLE_ENTREE,
+                 decalage == ENR_ETAT ? "état" : decalage < ENR_APP_ID_HASH ? "séquence" : "données");
+    }
+    else if(position >= graine && position < graine + TAILLE_GRAINE){
+        snprintf(nom, taille, "graine, octet %u", position - graine);
+    }
+    else{
+        snprintf(nom, taille, "position %u", position);
+    }
+}
+
+static void simulation(const scenario *s){
+    uint8_t total = s->fixes + s->tournantes;
+    uint32_t max = 0, ecritures = 0;
+    uint16_t position_max = 0;
+    char nom[64];
+
+    hote_eeprom_effacement();
+    chargement_magasin();
+    for(uint8_t a=0; a<total; a++){
+        for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+            applications[a][i] = rand();
+        }
+        enregistrement(a);
+    }
+    hote_eeprom_usure_raz();
+
+    for(uint32_t jour=1; jour<=JOURS; jour++){
+        for(uint8_t d=0; d<s->demarrages; d++){
+            redemarrage(total);
+        }
+        if(s->tournantes){
+            enregistrement(s->fixes + jour % s->tournantes);
+        }
+        if(s->periode_reset && jour % s->periode_reset == 0){
+            suppression_entrees_eeprom();
+            for(uint8_t a=0; a<total; a++){
+                enregistrement(a);
+            }
+        }
+    }
+
+    for(uint16_t p=0; p<hote_eeprom_taille(); p++){
+        ecritures += hote_eeprom_usure(p);
+        if(hote_eeprom_usure(p) > max){
+            max = hote_eeprom_usure(p);
+            position_max = p;
+        }
+    }
+    nom_octet(position_max, nom, sizeof(nom));
+
+    //  Ancienne disposition : le compteur d'entrées (un enregistrement ou RESET) et le compteur de démarrages
+    double enregistrements_jour = (s->tournantes ? 1.0 : 0.0)
+                                  + (s->periode_reset ? (1.0 + total) / s->periode_reset : 0.0);
+    double ancien_jour = enregistrements_jour > s->demarrages ? enregistrements_jour : s->demarrages;
+    double max_jour = (double)max / JOURS;
+
+    printf("%-17s | %5u | %9.1f | %-26s | %8.3f | %15.0f | %15.0f\n", s->nom, total, (double)ecritures / JOURS, nom,
+           max_jour, ENDURANCE / max_jour / 365, ENDURANCE / ancien_jour / 365);
+}
+
+//  Coût d'une opération : écart des compteurs de ecriture_eeprom() et de l'horloge virtuelle depuis 'debut'
+typedef struct {
+    uint32_t demandes, programmes;
+    uint64_t ns;
+} mesure;
+
+static mesure debut_mesure(){
+    mesure m = {eeprom_octets_demandes, eeprom_octets_programmes, hote_horloge_ns};
+    return m;
+}
+
+static void fin_mesure(const char *operation, mesure debut){
+    printf("%-28s | %8u | %10u | %8.1f\n", operation, eeprom_octets_demandes - debut.demandes,
+           eeprom_octets_programmes - debut.programmes, (hote_horloge_ns - debut.ns) / 1e6);
+}
+
+static void couts(){
+    mesure m;
+    printf("%-28s | demandés | programmés | ms\n", "opération");
+    hote_eeprom_effacement();
+    m = debut_mesure();
+    redemarrage(0);
+    fin_mesure("premier démarrage", m);
+    for(int i=0; i<NB_CELLULES_ENTETE; i++){
+        redemarrage(0);     // Toutes les cellules de l'en-tête écrites une fois
+    }
+    m = debut_mesure();
+    redemarrage(0);
+    fin_mesure("démarrage", m);
+
+    for(uint8_t a=0; a<12; a++){
+        for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+            applications[a][i] = rand();
+        }
+        m = debut_mesure();
+        enregistrement(a);
+    }
+    fin_mesure("nouvelle entrée", m);
+    m = debut_mesure();
+    enregistrement(0);
+    fin_mesure("réenregistrement", m);
+    m = debut_mesure();
+    suppression_entrees_eeprom();
+    fin_mesure("RESET (12 entrées)", m);
+    m = debut_mesure();
+    enregistrement(0);
+    fin_mesure("enregistrement après RESET", m);
+    printf("\n");
+}
+
+int main(){
+    srand(1);
+    sei();      // Collecte d'entropie de initialisation_aleatoire() (réveil par le chien de garde)
+    couts();
+    printf("%d jours simulés, %d écritures par octet avant usure\n", JOURS, ENDURANCE);
+    printf("scénario          | appli | octets/j  | octet le plus écrit        | écrits/j | durée (années)  "
+           "| ancienne disp.\n");
+    for(size_t i=0; i<sizeof(scenarios) / sizeof(scenarios[0]); i++){
+        simulation(&scenarios[i]);
+    }
+    if(echecs){
+        printf("ECHEC : %d erreur(s)\n", echecs);
+        return 1;
+    }
+    return 0;
+}
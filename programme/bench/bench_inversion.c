@@ -0,0 +1,331 @@
+/*  Banc d'essai de vli_modInv() et vli_modInv_n() (inversions modulo p et modulo n de secp160r1) à temps constant
+    (uECC_CONST_TIME_INV) : puissances de Fermat de uECC.c, ou safegcd de asm_x86_64.inc sur PC, contre l'ancien
+    GCD binaire étendu (recopié ici comme référence, sur un nombre de mots quelconque). Sur PC, le programme est
+    compilé deux fois : bench/bench_inversion (safegcd) et bench/bench_inversion_fermat (-Dx86_64_SAFEGCD=0). Sur la
+    carte aussi : bench/bench_inversion.hex (Fermat) et bench/bench_inversion_gcd.hex (uECC_CONST_TIME_INV à 0, le
+    GCD binaire de uECC.c), pour comparer uECC_make_key() et uECC_sign() avec et sans les inversions à temps constant.
+    1. Mêmes inverses que la référence, et x * (1 / x) = 1, sur des valeurs aléatoires et des cas limites (1, 2,
+       p - 1, n - 1, puissances de 2), 0 donnant 0 (code de retour non nul en cas d'erreur) ;
+    2. cycles par inversion, minimum et maximum sur ces valeurs : l'écart du GCD binaire dépend de x, celui des
+       inversions à temps constant ne vient que de la machine ; puis cycles de uECC_make_key() et uECC_sign().
+
+    Le même fichier se compile pour le PC (cycles lus avec rdtsc) et pour l'atmega328p (cycles comptés par le
+    Timer1, résultats envoyés sur la liaison série à 115200 bauds) :
+        make bench-hote                                   (PC)
+        make bench/bench_inversion.hex upload-bench-inversion  (carte, Fermat)
+        make bench/bench_inversion_gcd.hex upload-bench-inversion-gcd  (carte, GCD binaire)  */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../uECC.c"
+
+#if !uECC_CONST_TIME_INV
+#define METHODE "GCD de uECC.c"
+#elif asm_modInv
+#define METHODE "safegcd"
+#else
+#define METHODE "Fermat"
+#endif
+
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#define BAUD 115200
+#include <util/setbaud.h>
+
+#define VERIFICATIONS 20
+#define REPETITIONS 4
+typedef uint32_t cycles_t;
+
+static volatile uint16_t debordements = 0;
+
+ISR(TIMER1_OVF_vect){
+    debordements++;
+}
+
+static cycles_t cycles(){
+    uint16_t haut, bas;
+    cli();
+    bas = TCNT1;
+    haut = debordements;
+    if((TIFR1 & (1 << TOV1)) && bas < 0x8000){     // Débordement arrivé pendant la lecture, pas encore traité
+        haut++;
+    }
+    sei();
+    return ((uint32_t)haut << 16) | bas;
+}
+
+static int uart_putchar(char c, FILE *flux){
+    if(c == '\n'){
+        uart_putchar('\r', flux);
+    }
+    while(!(UCSR0A & (1 << UDRE0)));
+    UDR0 = c;
+    return 0;
+}
+
+static FILE sortie_uart = FDEV_SETUP_STREAM(uart_putchar, NULL, _FDEV_SETUP_WRITE);
+
+static void initialisation(){
+    UBRR0H = UBRRH_VALUE;
+    UBRR0L = UBRRL_VALUE;
+#if USE_2X
+    UCSR0A |= (1 << U2X0);
+#else
+    UCSR0A &= ~(1 << U2X0);
+#endif
+    UCSR0B = (1 << TXEN0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    stdout = &sortie_uart;
+
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);       // Horloge du processeur, sans prédiviseur
+    TIMSK1 = (1 << TOIE1);
+    sei();
+}
+#else
+#include <x86intrin.h>
+
+#define VERIFICATIONS 20000
+#define REPETITIONS 200
+typedef uint64_t cycles_t;
+
+static cycles_t cycles(){
+    return __rdtsc();
+}
+
+static void initialisation(){
+}
+#endif
+
+#define CAS 8           // Valeurs mesurées : 1, 2, p - 1 (ou n - 1), 2^k, et 4 valeurs aléatoires
+
+static uint32_t graine = 1;
+
+static int rng_bench(uint8_t *destination, unsigned taille){
+    for(unsigned i=0; i<taille; i++){
+        graine ^= graine << 13;
+        graine ^= graine >> 17;
+        graine ^= graine << 5;
+        destination[i] = graine;
+    }
+    return 1;
+}
+
+//  Ancienne inversion (GCD binaire étendu de uECC.c) sur 'mots' mots (référence)
+static int compare_reference(const uECC_word_t *a, const uECC_word_t *b, wordcount_t mots){
+    for(swordcount_t i=mots-1; i>=0; i--){
+        if(a[i] != b[i]){
+            return a[i] > b[i] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+static uECC_word_t addition_reference(uECC_word_t *r, const uECC_word_t *a, const uECC_word_t *b, wordcount_t mots){
+    uECC_word_t retenue = 0;
+    for(wordcount_t i=0; i<mots; i++){
+        uECC_word_t s = a[i] + b[i] + retenue;
+        if(s != a[i]){
+            retenue = (s < a[i]);
+        }
+        r[i] = s;
+    }
+    return retenue;
+}
+
+static void soustraction_reference(uECC_word_t *r, const uECC_word_t *a, const uECC_word_t *b, wordcount_t mots){
+    uECC_word_t emprunt = 0;
+    for(wordcount_t i=0; i<mots; i++){
+        uECC_word_t d = a[i] - b[i] - emprunt;
+        if(d != a[i]){
+            emprunt = (d > a[i]);
+        }
+        r[i] = d;
+    }
+}
+
+//  x = x / 2 modulo 'mod', le bit de retenue de x + mod replacé en haut
+static void moitie_reference(uECC_word_t *x, const uECC_word_t *mod, wordcount_t mots){
+    uECC_word_t retenue = 0;
+    if(!EVEN(x)){
+        retenue = addition_reference(x, x, mod, mots);
+    }
+    for(wordcount_t i=0; i<mots; i++){
+        x[i] = (x[i] >> 1) | (i + 1 < mots ? x[i + 1] << (uECC_WORD_BITS - 1) : retenue << (uECC_WORD_BITS - 1));
+    }
+}
+
+static void inverse_reference(uECC_word_t *resultat, const uECC_word_t *x, const uECC_word_t *mod, wordcount_t mots){
+    uECC_word_t a[uECC_N_WORDS], b[uECC_N_WORDS], u[uECC_N_WORDS], v[uECC_N_WORDS], zero[uECC_N_WORDS] = {0};
+    int c;
+
+    memset(resultat, 0, mots * sizeof(uECC_word_t));
+    if(!compare_reference(x, zero, mots)){
+        return;
+    }
+    memcpy(a, x, mots * sizeof(uECC_word_t));
+    memcpy(b, mod, mots * sizeof(uECC_word_t));
+    memset(u, 0, sizeof(u));
+    memset(v, 0, sizeof(v));
+    u[0] = 1;
+    while((c = compare_reference(a, b, mots)) != 0){
+        if(EVEN(a)){
+            moitie_reference(a, zero, mots);
+            moitie_reference(u, mod, mots);
+        } else if(EVEN(b)){
+            moitie_reference(b, zero, mots);
+            moitie_reference(v, mod, mots);
+        } else if(c > 0){
+            soustraction_reference(a, a, b, mots);
+            moitie_reference(a, zero, mots);
+            if(compare_reference(u, v, mots) < 0){
+                addition_reference(u, u, mod, mots);
+            }
+            soustraction_reference(u, u, v, mots);
+            moitie_reference(u, mod, mots);
+        } else {
+            soustraction_reference(b, b, a, mots);
+            moitie_reference(b, zero, mots);
+            if(compare_reference(v, u, mots) < 0){
+                addition_reference(v, v, mod, mots);
+            }
+            soustraction_reference(v, v, u, mots);
+            moitie_reference(v, mod, mots);
+        }
+    }
+    memcpy(resultat, u, mots * sizeof(uECC_word_t));
+}
+
+//  Valeur d'essai numéro i modulo 'mod' : 1, 2, mod - 1, une puissance de 2, puis aléatoire
+static void valeur(uECC_word_t *x, int i, const uECC_word_t *mod, wordcount_t mots){
+    memset(x, 0, uECC_N_WORDS * sizeof(uECC_word_t));
+    switch(i){
+    case 0:
+        x[0] = 1;
+        break;
+    case 1:
+        x[0] = 2;
+        break;
+    case 2:
+        memcpy(x, mod, mots * sizeof(uECC_word_t));
+        x[0] -= 1;
+        break;
+    case 3:
+        x[(mots - 1) / 2] = (uECC_word_t)1 << (uECC_WORD_BITS - 1);
+        break;
+    default:
+        do{
+            rng_bench((uint8_t *)x, mots * sizeof(uECC_word_t));
+            x[mots - 1] &= mod[mots - 1];
+        } while(compare_reference(mod, x, mots) != 1);
+    }
+}
+
+static long erreurs = 0;
+
+static void verification(int condition, const char *message){
+    if(!condition){
+        if(erreurs < 10){
+            printf("ERREUR : %s\n", message);
+        }
+        erreurs++;
+    }
+}
+
+static void essai_p(int i){
+    uECC_word_t x[uECC_N_WORDS], attendu[uECC_N_WORDS], obtenu[uECC_WORDS], produit[uECC_WORDS];
+    valeur(x, i, curve_p, uECC_WORDS);
+    inverse_reference(attendu, x, curve_p, uECC_WORDS);
+    vli_modInv(obtenu, x, curve_p);
+    verification(!memcmp(attendu, obtenu, uECC_BYTES), "vli_modInv différent de la référence");
+    vli_modMult_fast(produit, x, obtenu);
+    verification(vli_numBits(produit, uECC_WORDS) == 1, "x * (1 / x) != 1 modulo p");
+}
+
+static void essai_n(int i){
+    uECC_word_t x[uECC_N_WORDS], attendu[uECC_N_WORDS], obtenu[uECC_N_WORDS], produit[uECC_N_WORDS];
+    valeur(x, i, curve_n, uECC_N_WORDS);
+    inverse_reference(attendu, x, curve_n, uECC_N_WORDS);
+    vli_modInv_n(obtenu, x, curve_n);
+    verification(!memcmp(attendu, obtenu, sizeof(obtenu)), "vli_modInv_n différent de la référence");
+    vli_modMult_n(produit, x, obtenu);
+    verification(vli_numBits(produit, uECC_N_WORDS) == 1, "x * (1 / x) != 1 modulo n");
+}
+
+//  Cycles minimum et maximum d'une inversion sur les CAS valeurs (meilleur de REPETITIONS mesures chacune)
+static void mesure(const char *nom, const uECC_word_t *mod, wordcount_t mots, int constant){
+    uECC_word_t x[uECC_N_WORDS], r[uECC_N_WORDS];
+    cycles_t minimum = (cycles_t)-1, maximum = 0;
+
+    graine = 3;
+    for(int i=0; i<CAS; i++){
+        cycles_t meilleur = (cycles_t)-1;
+        valeur(x, i, mod, mots);
+        for(int j=0; j<REPETITIONS; j++){
+            cycles_t debut = cycles();
+            if(!constant){
+                inverse_reference(r, x, mod, mots);
+            } else if(mod == curve_p){
+                vli_modInv(r, x, curve_p);
+            } else {
+                vli_modInv_n(r, x, curve_n);
+            }
+            debut = cycles() - debut;
+            meilleur = debut < meilleur ? debut : meilleur;
+        }
+        minimum = meilleur < minimum ? meilleur : minimum;
+        maximum = meilleur > maximum ? meilleur : maximum;
+    }
+    printf("%-28s | %10lu | %10lu\n", nom, (unsigned long)minimum, (unsigned long)maximum);
+}
+
+int main(){
+    uint8_t cle_publique[uECC_BYTES * 2], cle_privee[uECC_BYTES], hash[uECC_BYTES], signature[uECC_BYTES * 2];
+    uECC_word_t x[uECC_N_WORDS], r[uECC_N_WORDS];
+    cycles_t debut;
+
+    initialisation();
+    uECC_set_rng(rng_bench);
+
+    //  1. Inverses
+    for(long i=0; i<VERIFICATIONS; i++){
+        essai_p(i < 4 ? i : 4);
+        essai_n(i < 4 ? i : 4);
+    }
+    memset(x, 0, sizeof(x));
+    vli_modInv(r, x, curve_p);
+    verification(vli_isZero(r), "1 / 0 modulo p");
+    vli_modInv_n(r, x, curve_n);
+    verification(vli_isZero_n(r), "1 / 0 modulo n");
+    if(erreurs){
+        printf("ERREUR : %ld inverse(s) faux\n", erreurs);
+        return 1;
+    }
+    printf("vli_modInv et vli_modInv_n identiques au GCD binaire sur %ld valeurs chacune\n\n", (long)VERIFICATIONS);
+
+    //  2. Cycles
+    printf("%-28s | %10s | %10s\n", "cycles par inversion", "minimum", "maximum");
+    mesure("modulo p, GCD binaire", curve_p, uECC_WORDS, 0);
+    mesure("modulo p, " METHODE, curve_p, uECC_WORDS, 1);
+    mesure("modulo n, GCD binaire", curve_n, uECC_N_WORDS, 0);
+    mesure("modulo n, " METHODE, curve_n, uECC_N_WORDS, 1);
+
+    debut = cycles();
+    for(int i=0; i<REPETITIONS; i++){
+        uECC_make_key(cle_publique, cle_privee);
+    }
+    printf("\nuECC_make_key : %lu cycles\n", (unsigned long)((cycles() - debut) / REPETITIONS));
+    rng_bench(hash, sizeof(hash));
+    debut = cycles();
+    for(int i=0; i<REPETITIONS; i++){
+        uECC_sign(cle_privee, hash, signature);
+    }
+    printf("uECC_sign     : %lu cycles\n", (unsigned long)((cycles() - debut) / REPETITIONS));
+
+#ifdef __AVR__
+    while(1);
+#endif
+    return 0;
+}
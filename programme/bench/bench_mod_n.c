@@ -0,0 +1,212 @@
+/*  Banc d'essai de vli_modMult_n() (multiplication modulo l'ordre n de la courbe) : réduction de Barrett contre
+    l'ancienne réduction bit à bit (boucle vli2_sub_n / vli2_rshift1_n, recopiée ici comme référence).
+    On vérifie d'abord que les deux donnent le même résultat (code de retour non nul sinon), puis on mesure les cycles
+    par multiplication, et le gain par signature : uECC_sign_with_k() fait 4 multiplications modulo n.
+
+    Le même fichier se compile pour le PC (cycles lus avec rdtsc) et pour l'atmega328p (cycles comptés par le
+    Timer1, résultats envoyés sur la liaison série à 115200 bauds) :
+        make bench-hote                              (PC)
+        make bench/bench_mod_n.hex upload-bench-mod-n   (carte)  */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../uECC.c"
+
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#define BAUD 115200
+#include <util/setbaud.h>
+
+#define VERIFICATIONS 50
+#define REPETITIONS 10
+typedef uint32_t cycles_t;
+
+static volatile uint16_t debordements = 0;
+
+ISR(TIMER1_OVF_vect){
+    debordements++;
+}
+
+static cycles_t cycles(){
+    uint16_t haut, bas;
+    cli();
+    bas = TCNT1;
+    haut = debordements;
+    if((TIFR1 & (1 << TOV1)) && bas < 0x8000){     // Débordement arrivé pendant la lecture, pas encore traité
+        haut++;
+    }
+    sei();
+    return ((uint32_t)haut << 16) | bas;
+}
+
+static int uart_putchar(char c, FILE *flux){
+    if(c == '\n'){
+        uart_putchar('\r', flux);
+    }
+    while(!(UCSR0A & (1 << UDRE0)));
+    UDR0 = c;
+    return 0;
+}
+
+static FILE sortie_uart = FDEV_SETUP_STREAM(uart_putchar, NULL, _FDEV_SETUP_WRITE);
+
+static void initialisation(){
+    UBRR0H = UBRRH_VALUE;
+    UBRR0L = UBRRL_VALUE;
+#if USE_2X
+    UCSR0A |= (1 << U2X0);
+#else
+    UCSR0A &= ~(1 << U2X0);
+#endif
+    UCSR0B = (1 << TXEN0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+    stdout = &sortie_uart;
+
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);       // Horloge du processeur, sans prédiviseur
+    TIMSK1 = (1 << TOIE1);
+    sei();
+}
+#else
+#include <x86intrin.h>
+
+#define VERIFICATIONS 100000
+#define REPETITIONS 20000
+typedef uint64_t cycles_t;
+
+static cycles_t cycles(){
+    return __rdtsc();
+}
+
+static void initialisation(){
+}
+#endif
+
+static uint32_t graine = 1;
+
+static int rng_bench(uint8_t *destination, unsigned taille){
+    for(unsigned i=0; i<taille; i++){
+        graine ^= graine << 13;
+        graine ^= graine >> 17;
+        graine ^= graine << 5;
+        destination[i] = graine;
+    }
+    return 1;
+}
+
+//  Ancienne réduction bit à bit (référence)
+static void vli2_rshift1_reference(uECC_word_t *vli){
+    vli_rshift1_n(vli);
+    vli[uECC_N_WORDS - 1] |= vli[uECC_N_WORDS] << (uECC_WORD_BITS - 1);
+    vli_rshift1_n(vli + uECC_N_WORDS);
+}
+
+static uECC_word_t vli2_sub_reference(uECC_word_t *result, const uECC_word_t *left, const uECC_word_t *right){
+    uECC_word_t borrow = 0;
+    for(wordcount_t i=0; i<uECC_N_WORDS * 2; ++i){
+        uECC_word_t diff = left[i] - right[i] - borrow;
+        if(diff != left[i]){
+            borrow = (diff > left[i]);
+        }
+        result[i] = diff;
+    }
+    return borrow;
+}
+
+static void vli_modMult_reference(uECC_word_t *result, const uECC_word_t *left, const uECC_word_t *right){
+    uECC_word_t product[2 * uECC_N_WORDS];
+    uECC_word_t modMultiple[2 * uECC_N_WORDS];
+    uECC_word_t tmp[2 * uECC_N_WORDS];
+    uECC_word_t *v[2] = {tmp, product};
+    uECC_word_t index = 1;
+
+    vli_mult_n(product, left, right);
+    vli_clear_n(modMultiple);
+    vli_set(modMultiple + uECC_N_WORDS + 1, curve_n);
+    vli_rshift1(modMultiple + uECC_N_WORDS + 1);
+    modMultiple[2 * uECC_N_WORDS - 1] |= HIGH_BIT_SET;
+    modMultiple[uECC_N_WORDS] = HIGH_BIT_SET;
+
+    for(bitcount_t i=0; i<=((((bitcount_t)uECC_N_WORDS) << uECC_WORD_BITS_SHIFT) + (uECC_WORD_BITS - 1)); ++i){
+        uECC_word_t borrow = vli2_sub_reference(v[1 - index], v[index], modMultiple);
+        index = !(index ^ borrow);
+        vli2_rshift1_reference(modMultiple);
+    }
+    vli_set_n(result, v[index]);
+}
+
+//  Opérande aléatoire < 2^161 (les entrées de vli_modMult_n dans uECC_sign_with_k)
+static void operande_aleatoire(uECC_word_t *x){
+    rng_bench((uint8_t *)x, uECC_N_WORDS * sizeof(uECC_word_t));
+    x[uECC_N_WORDS - 1] &= 0x01;
+}
+
+int main(){
+    uECC_word_t a[uECC_N_WORDS], b[uECC_N_WORDS], attendu[uECC_N_WORDS], obtenu[uECC_N_WORDS];
+    uint8_t cle_publique[uECC_BYTES * 2], cle_privee[uECC_BYTES], hash[uECC_BYTES], signature[uECC_BYTES * 2];
+    cycles_t debut, reference, barrett, signature_barrett;
+    long erreurs = 0;
+
+    initialisation();
+    uECC_set_rng(rng_bench);
+
+    //  Cas limites (opérandes maximales et n-1), puis opérandes aléatoires
+    for(long i=0; i<VERIFICATIONS; i++){
+        if(i == 0){
+            memset(a, 0xFF, sizeof(a));
+            a[uECC_N_WORDS - 1] = 0x01;
+            vli_set_n(b, a);
+        }
+        else if(i == 1){
+            vli_set_n(a, curve_n);
+            a[0] -= 1;
+            vli_set_n(b, a);
+        }
+        else{
+            operande_aleatoire(a);
+            operande_aleatoire(b);
+        }
+        vli_modMult_reference(attendu, a, b);
+        vli_modMult_n(obtenu, a, b);
+        if(memcmp(attendu, obtenu, sizeof(attendu))){
+            erreurs++;
+        }
+    }
+    if(erreurs){
+        printf("ERREUR : %ld résultat(s) différent(s) de la réduction bit à bit\n", erreurs);
+        return 1;
+    }
+    printf("Barrett et réduction bit à bit identiques sur %ld produits\n\n", (long)VERIFICATIONS);
+
+    debut = cycles();
+    for(int i=0; i<REPETITIONS; i++){
+        vli_modMult_reference(obtenu, a, b);
+    }
+    reference = (cycles() - debut) / REPETITIONS;
+
+    debut = cycles();
+    for(int i=0; i<REPETITIONS; i++){
+        vli_modMult_n(obtenu, a, b);
+    }
+    barrett = (cycles() - debut) / REPETITIONS;
+
+    uECC_make_key(cle_publique, cle_privee);
+    rng_bench(hash, sizeof(hash));
+    debut = cycles();
+    for(int i=0; i<REPETITIONS; i++){
+        uECC_sign(cle_privee, hash, signature);
+    }
+    signature_barrett = (cycles() - debut) / REPETITIONS;
+
+    printf("vli_modMult_n bit à bit : %lu cycles\n", (unsigned long)reference);
+    printf("vli_modMult_n Barrett   : %lu cycles\n", (unsigned long)barrett);
+    printf("uECC_sign (Barrett)     : %lu cycles, %lu cycles gagnés par signature (4 multiplications)\n",
+           (unsigned long)signature_barrett, (unsigned long)(4 * (reference - barrett)));
+
+#ifdef __AVR__
+    while(1);
+#endif
+    return 0;
+}
@@ -0,0 +1,295 @@
+/*  Test et banc d'essai hôte des noyaux x86_64 de uECC (asm_x86_64.inc) : vli_mult(), vli_square() et vli_mult_n()
+    en MULX/ADCX/ADOX, vli_mmod_fast() sur des mots de 64 bits. Ils sont comparés au calcul en C utilisé sur les
+    processeurs sans BMI2/ADX, et à une référence simple recopiée ici (produit mot à mot sur 32 bits, reste bit à bit).
+    1. Produits, carrés et restes modulo p de valeurs aléatoires et de cas limites (0, 1, valeurs maximales, p - 1),
+       avec et sans MULX ;
+    2. uECC_sign() avec et sans MULX : mêmes clés et mêmes signatures pour la même suite aléatoire, acceptées par
+       uECC_verify() de l'autre mode ;
+    3. cycles (rdtsc) par opération avec et sans MULX.
+    Sans BMI2/ADX (sélection par CPUID au chargement), seul le calcul en C est testé.
+    Le programme s'arrête avec un code de retour non nul en cas d'erreur.
+    Compilation et exécution : make test-hote ou make bench-hote (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <x86intrin.h>
+
+#include "../uECC.c"
+
+#if !asm_mult
+#error "noyaux x86_64 absents (asm_x86_64.inc, uECC_ASM non nul)"
+#endif
+
+#define VERIFICATIONS 100000
+#define SIGNATURES 200
+#define SERIES 5
+#define REPETITIONS 2000
+#define MOTS (uECC_BYTES / 4)       // Mots de 32 bits de la référence
+
+static uint32_t graine = 1;
+
+static int rng_bench(uint8_t *destination, unsigned taille){
+    for(unsigned i=0; i<taille; i++){
+        graine ^= graine << 13;
+        graine ^= graine >> 17;
+        graine ^= graine << 5;
+        destination[i] = graine;
+    }
+    return 1;
+}
+
+//  Produit de référence de deux valeurs de 'mots' mots de 32 bits
+static void produit_reference(uint32_t *resultat, const uint32_t *a, const uint32_t *b, int mots){
+    memset(resultat, 0, 2 * mots * sizeof(uint32_t));
+    for(int i=0; i<mots; i++){
+        uint64_t retenue = 0;
+        for(int j=0; j<mots; j++){
+            uint64_t t = (uint64_t)a[i] * b[j] + resultat[i + j] + retenue;
+            resultat[i + j] = t;
+            retenue = t >> 32;
+        }
+        resultat[i + mots] = retenue;
+    }
+}
+
+//  Reste de référence modulo p, bit à bit : r = 2r + bit, moins p si r >= p
+static void reste_reference(uint32_t resultat[MOTS], const uint32_t produit[2 * MOTS]){
+    uint32_t r[MOTS + 1] = {0}, p[MOTS + 1] = {0};
+    memcpy(p, curve_p, uECC_BYTES);
+    for(int bit=2*uECC_BYTES*8-1; bit>=0; bit--){
+        uint32_t retenue = (produit[bit / 32] >> (bit % 32)) & 1;
+        for(int i=0; i<=MOTS; i++){
+            uint32_t haut = r[i] >> 31;
+            r[i] = (r[i] << 1) | retenue;
+            retenue = haut;
+        }
+        int i = MOTS;
+        while(i > 0 && r[i] == p[i]){
+            i--;
+        }
+        if(r[i] >= p[i]){
+            uint64_t emprunt = 0;
+            for(i=0; i<=MOTS; i++){
+                uint64_t d = (uint64_t)r[i] - p[i] - emprunt;
+                r[i] = d;
+                emprunt = (d >> 32) & 1;
+            }
+        }
+    }
+    memcpy(resultat, r, uECC_BYTES);
+}
+
+static int adx_processeur;      // BMI2 et ADX détectés par asm_x86_64.inc
+static int erreurs = 0;
+
+static void verification(int condition, const char *message){
+    if(!condition){
+        if(erreurs < 10){
+            printf("ECHEC : %s (%s)\n", message, x86_64_adx ? "MULX" : "C");
+        }
+        erreurs++;
+    }
+}
+
+//  Produit, carré et reste modulo p de a et b, dans chaque mode disponible
+static void essai(const uECC_word_t a[uECC_WORDS], const uECC_word_t b[uECC_WORDS]){
+    uint32_t a32[MOTS], b32[MOTS], produit[2 * MOTS], carre[2 * MOTS], reste[MOTS];
+    uECC_word_t resultat[2 * uECC_WORDS], copie[2 * uECC_WORDS], reduit[uECC_WORDS];
+
+    memcpy(a32, a, uECC_BYTES);
+    memcpy(b32, b, uECC_BYTES);
+    produit_reference(produit, a32, b32, MOTS);
+    produit_reference(carre, a32, a32, MOTS);
+    reste_reference(reste, produit);
+    for(int mode=0; mode<=adx_processeur; mode++){
+        x86_64_adx = mode;
+        vli_mult(resultat, a, b);
+        verification(!memcmp(resultat, produit, 2 * uECC_BYTES), "vli_mult");
+        vli_square(resultat, a);
+        verification(!memcmp(resultat, carre, 2 * uECC_BYTES), "vli_square");
+        memcpy(copie, produit, 2 * uECC_BYTES);
+        vli_mmod_fast(reduit, copie);
+        verification(!memcmp(reduit, reste, uECC_BYTES), "vli_mmod_fast");
+    }
+}
+
+#if (uECC_CURVE == uECC_secp160r1)
+//  vli_mult_n sur toute la largeur de uECC_N_WORDS mots
+static void essai_n(const uECC_word_t a[uECC_N_WORDS], const uECC_word_t b[uECC_N_WORDS]){
+    uint32_t produit[2 * uECC_N_WORDS];
+    uECC_word_t resultat[2 * uECC_N_WORDS];
+
+    produit_reference(produit, a, b, uECC_N_WORDS);
+    for(int mode=0; mode<=adx_processeur; mode++){
+        x86_64_adx = mode;
+        vli_mult_n(resultat, a, b);
+        verification(!memcmp(resultat, produit, sizeof(produit)), "vli_mult_n");
+    }
+}
+#endif
+
+//  Données des opérations mesurées
+static uECC_word_t gauche[16][uECC_WORDS], droite[16][uECC_WORDS];
+static uint8_t cle_publique[uECC_BYTES * 2], cle_privee[uECC_BYTES], hash[uECC_BYTES], signature[uECC_BYTES * 2];
+
+static void op_multiplication(int i){
+    uECC_word_t r[uECC_WORDS];
+    vli_modMult_fast(r, gauche[i & 15], droite[i & 15]);
+}
+
+static void op_carre(int i){
+    uECC_word_t r[uECC_WORDS];
+    vli_modSquare_fast(r, gauche[i & 15]);
+}
+
+#if (uECC_CURVE == uECC_secp160r1)
+static void op_multiplication_n(int i){
+    uECC_word_t a[uECC_N_WORDS] = {0}, b[uECC_N_WORDS] = {0}, r[uECC_N_WORDS];
+    vli_set(a, gauche[i & 15]);
+    vli_set(b, droite[i & 15]);
+    vli_modMult_n(r, a, b);
+}
+#endif
+
+static void op_cle(int i){
+    uECC_make_key(cle_publique, cle_privee);
+}
+
+static void op_signature(int i){
+    uECC_sign(cle_privee, hash, signature);
+}
+
+static void op_verification(int i){
+    uECC_verify(cle_publique, hash, signature);
+}
+
+//  Cycles par opération : meilleure moyenne sur SERIES séries (la machine hôte n'est pas dédiée au banc)
+static uint64_t cycles(void (*operation)(int), int repetitions){
+    uint64_t meilleur = UINT64_MAX;
+    for(int serie=0; serie<SERIES; serie++){
+        uint64_t debut = __rdtsc();
+        for(int i=0; i<repetitions; i++){
+            operation(i);
+        }
+        uint64_t moyenne = (__rdtsc() - debut) / repetitions;
+        if(moyenne < meilleur){
+            meilleur = moyenne;
+        }
+    }
+    return meilleur;
+}
+
+//  Ligne du tableau : cycles sans et avec MULX (largeur comptée en caractères et non en octets UTF-8)
+static void ligne(const char *nom, void (*operation)(int), int repetitions){
+    uint64_t c, mulx = 0;
+    int largeur = 24;
+    for(const char *p=nom; *p; p++){
+        largeur += ((*p & 0xC0) == 0x80);
+    }
+    x86_64_adx = 0;
+    c = cycles(operation, repetitions);
+    printf("%-*s | %12llu", largeur, nom, (unsigned long long)c);
+    if(adx_processeur){
+        x86_64_adx = 1;
+        mulx = cycles(operation, repetitions);
+        printf(" | %12llu  (x%.2f)", (unsigned long long)mulx, (double)c / mulx);
+    }
+    printf("\n");
+}
+
+int main(){
+    uECC_word_t a[uECC_WORDS], b[uECC_WORDS];
+    static uint8_t signatures[2][SIGNATURES][uECC_BYTES * 2], cles[2][SIGNATURES][uECC_BYTES * 2];
+    static uint8_t hashes[SIGNATURES][uECC_BYTES];
+
+    adx_processeur = x86_64_adx;
+    printf("Processeur %s BMI2/ADX : %s\n\n", adx_processeur ? "avec" : "sans",
+           adx_processeur ? "noyaux MULX/ADCX/ADOX et calcul en C testés" : "calcul en C seul testé");
+    uECC_set_rng(rng_bench);
+
+    //  1. Cas limites : 0, 1, valeurs maximales, p - 1 ; puis valeurs aléatoires
+    vli_clear(a);
+    vli_clear(b);
+    essai(a, b);
+    a[0] = 1;
+    essai(a, a);
+    memset(a, 0xFF, sizeof(a));
+    essai(a, a);
+    essai(a, b);
+    vli_set(b, curve_p);
+    b[0] -= 1;
+    essai(b, b);
+    essai(a, b);
+    for(int i=0; i<VERIFICATIONS; i++){
+        rng_bench((uint8_t *)a, sizeof(a));
+        rng_bench((uint8_t *)b, sizeof(b));
+        essai(a, b);
+    }
+#if (uECC_CURVE == uECC_secp160r1)
+    uECC_word_t an[uECC_N_WORDS], bn[uECC_N_WORDS];
+    memset(an, 0xFF, sizeof(an));
+    essai_n(an, an);
+    for(int i=0; i<VERIFICATIONS; i++){
+        rng_bench((uint8_t *)an, sizeof(an));
+        rng_bench((uint8_t *)bn, sizeof(bn));
+        essai_n(an, bn);
+    }
+#endif
+    if(erreurs){
+        printf("ECHEC : %d erreur(s)\n", erreurs);
+        return 1;
+    }
+    printf("vli_mult, vli_square, vli_mmod_fast%s : %d valeurs identiques à la référence\n",
+           uECC_CURVE == uECC_secp160r1 ? ", vli_mult_n" : "", VERIFICATIONS + 6);
+
+    //  2. Mêmes clés et signatures dans les deux modes, vérifiées par l'autre mode
+    rng_bench((uint8_t *)hashes, sizeof(hashes));
+    for(int mode=0; mode<=adx_processeur; mode++){
+        x86_64_adx = mode;
+        graine = 1;
+        for(int i=0; i<SIGNATURES; i++){
+            verification(uECC_make_key(cles[mode][i], cle_privee) && uECC_sign(cle_privee, hashes[i], signatures[mode][i]),
+                         "uECC_make_key / uECC_sign");
+        }
+    }
+    for(int mode=0; mode<=adx_processeur; mode++){
+        x86_64_adx = mode;
+        for(int i=0; i<SIGNATURES; i++){
+            verification(uECC_verify(cles[!mode && adx_processeur][i], hashes[i], signatures[!mode && adx_processeur][i]),
+                         "uECC_verify");
+        }
+    }
+    verification(!memcmp(cles[0], cles[adx_processeur], sizeof(cles[0]))
+                 && !memcmp(signatures[0], signatures[adx_processeur], sizeof(signatures[0])),
+                 "clés ou signatures différentes entre les modes");
+    if(erreurs){
+        printf("ECHEC : %d erreur(s)\n", erreurs);
+        return 1;
+    }
+    printf("uECC_sign / uECC_verify : %d signatures identiques et acceptées dans les deux modes\n\n", SIGNATURES);
+
+    //  3. Cycles
+    for(int i=0; i<16; i++){
+        rng_bench((uint8_t *)gauche[i], sizeof(gauche[i]));
+        rng_bench((uint8_t *)droite[i], sizeof(droite[i]));
+    }
+    rng_bench(hash, sizeof(hash));
+    uECC_make_key(cle_publique, cle_privee);
+    uECC_sign(cle_privee, hash, signature);
+
+    printf("%-25s | %12s", "opération", "C 64 bits");
+    if(adx_processeur){
+        printf(" | %12s", "MULX/ADX");
+    }
+    printf("\n");
+    ligne("vli_modMult_fast", op_multiplication, 100 * REPETITIONS);
+    ligne("vli_modSquare_fast", op_carre, 100 * REPETITIONS);
+#if (uECC_CURVE == uECC_secp160r1)
+    ligne("vli_modMult_n", op_multiplication_n, 100 * REPETITIONS);
+#endif
+    ligne("uECC_make_key", op_cle, REPETITIONS / 4);
+    ligne("uECC_sign", op_signature, REPETITIONS / 4);
+    ligne("uECC_verify", op_verification, REPETITIONS / 4);
+    x86_64_adx = adx_processeur;
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*  Banc d'essai hôte du calcul de k*G dans uECC : peigne à base fixe (uECC_FIXED_BASE_COMB) contre l'échelle de
+    Montgomery co-Z d'origine, appelée comme dans uECC_sign (scalaire régularisé, 162 bits).
+    On vérifie d'abord que les deux méthodes donnent le même point sur des scalaires aléatoires et des cas limites
+    (le programme s'arrête avec un code de retour non nul sinon), puis on mesure les cycles (rdtsc) par opération.
+    Compilation et exécution : make bench-hote (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <x86intrin.h>
+
+#define uECC_LADDER 1
+#include "../uECC.c"
+
+#define VERIFICATIONS 1000
+#define SERIES 5
+#define REPETITIONS 400
+
+static uint32_t graine = 1;
+
+static int rng_bench(uint8_t *destination, unsigned taille){
+    for(unsigned i=0; i<taille; i++){
+        graine ^= graine << 13;
+        graine ^= graine >> 17;
+        graine ^= graine << 5;
+        destination[i] = graine;
+    }
+    return 1;
+}
+
+//  Scalaire aléatoire dans [1, n-1]
+static void scalaire_aleatoire(uECC_word_t k[uECC_N_WORDS]){
+    do{
+        rng_bench((uint8_t *)k, uECC_N_WORDS * sizeof(uECC_word_t));
+        k[uECC_N_WORDS - 1] &= 0x01;
+    } while(vli_isZero_n(k) || vli_cmp_n(curve_n, k) != 1);
+}
+
+//  k*G par l'échelle, avec la régularisation de uECC_sign_with_k
+static void echelle(EccPoint *resultat, const uECC_word_t k[uECC_N_WORDS]){
+    uECC_word_t tmp[uECC_N_WORDS];
+    uECC_word_t s[uECC_N_WORDS];
+    uECC_word_t *k2[2] = {tmp, s};
+    uECC_word_t retenue;
+
+    vli_add_n(tmp, k, curve_n);
+    retenue = (tmp[uECC_WORDS] & 0x02);
+    vli_add_n(s, tmp, curve_n);
+    EccPoint_mult(resultat, &curve_G, k2[!retenue], 0, (uECC_BYTES * 8) + 2);
+}
+
+//  Compare le peigne à 'attendu', ou à l'échelle si 'attendu' est nul
+static int verification(const uECC_word_t k[uECC_N_WORDS], const EccPoint *attendu){
+    EccPoint reference, obtenu;
+    if(!attendu){
+        echelle(&reference, k);
+        attendu = &reference;
+    }
+    EccPoint_mult_comb(&obtenu, k);
+    if(memcmp(attendu, &obtenu, sizeof(EccPoint))){
+        printf("ERREUR : le peigne et l'échelle diffèrent pour k =");
+        for(int i=uECC_N_WORDS-1; i>=0; i--){
+            printf(" %0*llx", (int)(2 * sizeof(uECC_word_t)), (unsigned long long)k[i]);
+        }
+        printf("\n");
+        return 0;
+    }
+    return 1;
+}
+
+//  Données des opérations mesurées
+static uECC_word_t scalaires[16][uECC_N_WORDS];
+static uint8_t cle_publique[uECC_BYTES * 2], cle_privee[uECC_BYTES], hash[uECC_BYTES], signature[uECC_BYTES * 2];
+static uECC_Nonce nonce;
+
+static void op_echelle(int i){
+    EccPoint p;
+    echelle(&p, scalaires[i & 15]);
+}
+
+static void op_peigne(int i){
+    EccPoint p;
+    EccPoint_mult_comb(&p, scalaires[i & 15]);
+}
+
+static void op_cle(int i){
+    uECC_make_key(cle_publique, cle_privee);
+}
+
+static void op_signature(int i){
+    uECC_sign(cle_privee, hash, signature);
+}
+
+static void op_nonce(int i){
+    uECC_make_nonce(&nonce);
+}
+
+static void op_signature_nonce(int i){
+    uECC_sign_with_nonce(cle_privee, hash, &nonce, signature);
+}
+
+//  Cycles par opération : meilleure moyenne sur SERIES séries (la machine hôte n'est pas dédiée au banc)
+static uint64_t cycles(void (*operation)(int)){
+    uint64_t meilleur = UINT64_MAX;
+    for(int serie=0; serie<SERIES; serie++){
+        uint64_t debut = __rdtsc();
+        for(int i=0; i<REPETITIONS; i++){
+            operation(i);
+        }
+        uint64_t moyenne = (__rdtsc() - debut) / REPETITIONS;
+        if(moyenne < meilleur){
+            meilleur = moyenne;
+        }
+    }
+    return meilleur;
+}
+
+//  Ligne du tableau de résultats (largeur comptée en caractères et non en octets UTF-8)
+static void ligne(const char *nom, uint64_t cycles, uint64_t reference){
+    int largeur = 28;
+    for(const char *c=nom; *c; c++){
+        largeur += ((*c & 0xC0) == 0x80);
+    }
+    printf("%-*s | %12llu", largeur, nom, (unsigned long long)cycles);
+    if(reference){
+        printf("  (x%.2f)", (double)reference / cycles);
+    }
+    printf("\n");
+}
+
+int main(){
+    uECC_word_t k[uECC_N_WORDS];
+    EccPoint p;
+    uint64_t cycles_echelle;
+    int erreurs = 0;
+
+    uECC_set_rng(rng_bench);
+
+    /*  Cas limites : 1 et n-1 (G et -G, cas où l'échelle co-Z elle-même est fausse), 2, 15 (une seule colonne),
+        2^160, puis des scalaires aléatoires  */
+    vli_clear_n(k); k[0] = 1; erreurs += !verification(k, &curve_G);
+    p = curve_G;
+    vli_sub(p.y, curve_p, curve_G.y);
+    vli_set_n(k, curve_n); k[0] -= 1; erreurs += !verification(k, &p);
+    vli_clear_n(k); k[0] = 2;  erreurs += !verification(k, 0);
+    vli_clear_n(k); k[0] = 15; erreurs += !verification(k, 0);
+    vli_clear_n(k); k[uECC_N_WORDS - 1] = 1; erreurs += !verification(k, 0);
+    for(int i=0; i<VERIFICATIONS; i++){
+        scalaire_aleatoire(k);
+        erreurs += !verification(k, 0);
+    }
+    if(erreurs){
+        printf("%d erreur(s)\n", erreurs);
+        return 1;
+    }
+    printf("Peigne et échelle identiques sur %d scalaires\n\n", VERIFICATIONS + 5);
+
+    for(int i=0; i<16; i++){
+        scalaire_aleatoire(scalaires[i]);
+    }
+    rng_bench(hash, sizeof(hash));
+    uECC_make_key(cle_publique, cle_privee);
+
+    cycles_echelle = cycles(op_echelle);
+    printf("%-29s | %12s\n", "opération", "cycles / op");
+    ligne("k*G échelle co-Z", cycles_echelle, 0);
+    ligne("k*G peigne", cycles(op_peigne), cycles_echelle);
+    ligne("uECC_make_key (peigne)", cycles(op_cle), 0);
+    ligne("uECC_sign (peigne)", cycles(op_signature), 0);
+    ligne("uECC_make_nonce (hors ligne)", cycles(op_nonce), 0);
+    ligne("uECC_sign_with_nonce", cycles(op_signature_nonce), 0);
+    return 0;
+}
@@ -0,0 +1,70 @@
+/*  Banc d'essai hôte de recherche_entree_eeprom() : coût d'une recherche en fonction du nombre d'entrées enregistrées.
+    Pour chaque nombre d'entrées (de 1 à MAX_ENTREES), on mesure le nombre d'octets lus dans l'eeprom et le temps
+    de calcul pour retrouver la dernière entrée enregistrée (pire cas d'un parcours linéaire) et pour un app_id absent.
+    Compilation et exécution : make bench-hote (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+#define REPETITIONS 10000
+
+static uint64_t maintenant_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void app_id_aleatoire(uint8_t *app_id_hash){
+    for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+        app_id_hash[i] = rand();
+    }
+}
+
+//  Mesure d'une recherche : octets lus dans l'eeprom (une recherche) et temps moyen en ns (REPETITIONS recherches)
+static void mesure(uint8_t *app_id_hash, uint32_t *octets_lus, double *temps_ns){
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID];
+    uint8_t private_key[TAILLE_CLE_PRIVE];
+
+    hote_compteurs_raz();
+    recherche_entree_eeprom(app_id_hash, credential_id, private_key);
+    *octets_lus = hote_eeprom_lectures;
+
+    uint64_t debut = maintenant_ns();
+    for(int i=0; i<REPETITIONS; i++){
+        recherche_entree_eeprom(app_id_hash, credential_id, private_key);
+    }
+    *temps_ns = (double)(maintenant_ns() - debut) / REPETITIONS;
+}
+
+int main(){
+    uint8_t app_id_hash[TAILLE_APP_ID_HASH];
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID] = {0};
+    uint8_t private_key[TAILLE_CLE_PRIVE] = {0};
+    uint8_t absent[TAILLE_APP_ID_HASH];
+    uint32_t octets_present, octets_absent;
+    double temps_present, temps_absent;
+
+    srand(1);
+    app_id_aleatoire(absent);
+
+    hote_eeprom_effacement();
+    chargement_magasin();
+
+    printf("entrees | octets lus (trouvee) | ns (trouvee) | octets lus (absente) | ns (absente)\n");
+    for(int n=1; n<=MAX_ENTREES; n++){
+        app_id_aleatoire(app_id_hash);
+        sauvegarde_entree_eeprom(app_id_hash, credential_id, private_key);
+
+        mesure(app_id_hash, &octets_present, &temps_present);
+        mesure(absent, &octets_absent, &temps_absent);
+        printf("%7d | %20u | %12.1f | %20u | %12.1f\n",
+               n, octets_present, temps_present, octets_absent, temps_absent);
+    }
+    return 0;
+}
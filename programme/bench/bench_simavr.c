@@ -0,0 +1,367 @@
+/*  Banc d'essai du programme de la carte au cycle près, sous simavr (simulateur de l'atmega328p, sans carte) :
+    main.elf est chargé tel quel dans le simulateur, qui lui envoie les requêtes du protocole sur l'USART0 et appuie
+    sur le bouton (PD2) à chaque demande de confirmation. Pour chaque commande et chaque nombre d'entrées dans l'eeprom
+    (de 0 à 16 entrées, soit 17 mesures par commande), on relève les cycles de chaque phase grâce aux repères que main.c écrit dans GPIOR0 (voir PHASE()) :
+        lecture       réception et lecture de la requête (octets reçus à 115200 bauds compris)
+        recherche     accès à l'eeprom : recherche de l'entrée, sauvegarde, suppression
+        crypto        uECC_make_key() ou signature
+        confirmation  attente de l'appui : filtrage du bouton (10 ms), aucun nonce n'est préparé pendant l'attente
+        reponse       du début de la réponse à la sortie de son dernier octet sur la liaison
+    Avant chaque commande, on attend que la carte soit en veille (réserve de nonces pleine). Au démarrage, la collecte
+    d'entropie de config() met aussi la carte en veille (environ 4 s au premier démarrage) : on attend la fin de la
+    phase PHASE_DEMARRAGE.
+    Pile : la SRAM est peinte (MOTIF_PILE) avant le démarrage ; à la fin, la zone jamais écrite sous la pile donne la
+    pile maximale de toute la session (signatures, uECC_make_key(), HMAC de la fonction aléatoire...) et la marge qui
+    restait au-dessus des variables globales, à comparer à PILE_MIN du Makefile.
+
+    Les résultats sont écrits en JSON sur la sortie standard, un résumé lisible sur la sortie d'erreur :
+        make bench      (programme compilé avec avr-gcc, résultats dans bench/bench_simavr.json)
+    Nécessite simavr (bibliothèque libsimavr et ses en-têtes) et libelf.  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "sim_irq.h"
+#include "avr_uart.h"
+#include "avr_ioport.h"
+
+#define F_CPU 16000000UL
+#define ADRESSE_GPIOR0 0x3E         // GPIOR0 = _SFR_IO8(0x1E), adresse dans l'espace des données
+#define CYCLES_OCTET (10 * F_CPU / 115200)  // Durée d'un octet sur la liaison (bit de start + 8 bits + stop)
+#define LIMITE_CYCLES (30 * F_CPU)  // Au-delà de 30 s simulées sans réponse, la carte est considérée bloquée
+#define DEBUT_SRAM 0x100            // SRAM de l'atmega328p : 0x100 à RAMEND (0x8FF)
+#define MOTIF_PILE 0xC5
+#define MOTIF_MIN 16                // Octets du motif consécutifs : zone jamais écrite
+
+//  Protocole (voir main.c)
+#define COMMAND_LIST_CREDENTIALS 0
+#define COMMAND_MAKE_CREDENTIAL 1
+#define COMMAND_GET_ASSERTION 2
+#define COMMAND_RESET 3
+#define COMMAND_LIST_PAGE 5
+#define COMMAND_GET_ASSERTIONS 6
+#define LOT 4                   // Signatures par GET_ASSERTIONS (LOT_MAX de main.c)
+#define STATUS_OK 0
+#define TAILLE_APP_ID_HASH 20
+#define TAILLE_CREDENTIAL_ID 16
+#define TAILLE_CLE_PUBLIC 40
+#define TAILLE_SIGNATURE 40
+#define TAILLE_DATA_HASH 20
+#define ENTREES_MAX 16
+
+//  Phases (voir PHASE_* dans main.c)
+#define PHASE_REPOS 0
+#define PHASE_LECTURE 1
+#define PHASE_RECHERCHE 2
+#define PHASE_CRYPTO 3
+#define PHASE_CONFIRMATION 4
+#define PHASE_REPONSE 5
+#define NB_PHASES 6
+#define PHASE_DEMARRAGE 6           // config(), hors mesure
+static const char *noms_phases[NB_PHASES] = {"repos", "lecture", "recherche", "crypto", "confirmation", "reponse"};
+
+typedef struct mesure{
+    const char *commande;
+    uint8_t entrees;                // Nombre d'entrées dans l'eeprom avant la commande
+    uint8_t statut;
+    uint16_t octets_reponse;
+    uint64_t cycles[NB_PHASES];
+    uint64_t total;
+} mesure;
+
+#define NB_MESURES_MAX 128
+static mesure mesures[NB_MESURES_MAX];
+static int nb_mesures = 0;
+
+static avr_t *avr;
+static avr_irq_t *uart_entree, *bouton;
+
+//  Phase en cours (dernière valeur écrite dans GPIOR0) et mesure en cours
+static uint8_t phase = PHASE_DEMARRAGE;
+static avr_cycle_count_t debut_phase;
+static mesure *en_cours = NULL;
+
+//  Réponse de la carte
+static uint8_t reponse[2 + ENTREES_MAX * (TAILLE_CREDENTIAL_ID + TAILLE_APP_ID_HASH)];
+static uint16_t recus = 0;
+static avr_cycle_count_t dernier_octet;
+
+/*  Écriture dans GPIOR0 : les cycles écoulés depuis le repère précédent sont comptés dans la phase précédente.
+    Pendant une mesure, le retour à PHASE_REPOS est ignoré : la réponse continue jusqu'à la sortie du dernier octet.  */
+static void ecriture_gpior0(avr_t *avr, avr_io_addr_t adresse, uint8_t valeur, void *parametre){
+    avr->data[adresse] = valeur;
+    if(en_cours && valeur == PHASE_REPOS){
+        return;
+    }
+    if(en_cours && valeur < NB_PHASES && valeur != phase){
+        en_cours->cycles[phase] += avr->cycle - debut_phase;
+        debut_phase = avr->cycle;
+    }
+    phase = valeur;
+}
+
+//  Octet émis par la carte
+static void uart_sortie(avr_irq_t *irq, uint32_t valeur, void *parametre){
+    if(recus < sizeof(reponse)){
+        reponse[recus++] = valeur;
+    }
+    dernier_octet = avr->cycle;
+}
+
+//  Exécution jusqu'à ce que la condition soit vraie (arrêt du banc si la carte est bloquée)
+static void execution(int (*condition)(void), const char *attente){
+    avr_cycle_count_t limite = avr->cycle + LIMITE_CYCLES;
+    while(!condition()){
+        int etat = avr_run(avr);
+        if(etat == cpu_Done || etat == cpu_Crashed || avr->cycle > limite){
+            fprintf(stderr, "ERREUR : carte bloquée (%s), cycle %llu\n", attente, (unsigned long long)avr->cycle);
+            exit(1);
+        }
+    }
+}
+
+//  Carte en veille hors de toute commande : réserve de nonces pleine (voir tour_boucle())
+static int inactive(){
+    return phase == PHASE_REPOS && avr->state == cpu_Sleeping;
+}
+
+//  Taille de la réponse attendue, d'après les octets déjà reçus
+static uint16_t commande_courante;
+
+static uint16_t taille_attendue(){
+    if(recus == 0 || reponse[0] != STATUS_OK){
+        return 1;
+    }
+    if(commande_courante == COMMAND_LIST_CREDENTIALS){
+        return recus < 2 ? 2 : 2 + reponse[1] * (TAILLE_CREDENTIAL_ID + TAILLE_APP_ID_HASH);
+    }
+    if(commande_courante == COMMAND_LIST_PAGE){
+        return recus < 2 ? 2 : 3 + reponse[1] * (TAILLE_CREDENTIAL_ID + TAILLE_APP_ID_HASH);
+    }
+    if(commande_courante == COMMAND_MAKE_CREDENTIAL){
+        return 1 + TAILLE_CREDENTIAL_ID + TAILLE_CLE_PUBLIC;
+    }
+    if(commande_courante == COMMAND_GET_ASSERTION){
+        return 1 + TAILLE_CREDENTIAL_ID + TAILLE_SIGNATURE;
+    }
+    if(commande_courante == COMMAND_GET_ASSERTIONS){
+        return 1 + TAILLE_CREDENTIAL_ID + LOT * TAILLE_SIGNATURE;
+    }
+    return 1;
+}
+
+/*  Fin de la commande : réponse complète, dernier octet sorti du registre à décalage et boucle principale revenue
+    au repos. L'appui est fait dès que la carte attend la confirmation (tous les calculs de la requête sont alors
+    faits).  */
+static int bouton_appuye = 0;
+
+static int commande_terminee(){
+    if(phase == PHASE_CONFIRMATION && !bouton_appuye){
+        avr_raise_irq(bouton, 0);
+        bouton_appuye = 1;
+    }
+    return recus >= taille_attendue() && avr->cycle >= dernier_octet + CYCLES_OCTET
+           && (uint8_t)avr->data[ADRESSE_GPIOR0] == PHASE_REPOS;
+}
+
+//  Envoi d'une requête (commande + données) et mesure de son traitement
+static void commande(const char *nom, const uint8_t *requete, uint16_t taille, uint8_t entrees){
+    if(nb_mesures == NB_MESURES_MAX){
+        fprintf(stderr, "ERREUR : trop de mesures\n");
+        exit(1);
+    }
+    execution(inactive, "attente de la veille");
+
+    mesure *m = &mesures[nb_mesures++];
+    memset(m, 0, sizeof(*m));
+    m->commande = nom;
+    m->entrees = entrees;
+    commande_courante = requete[0];
+    recus = 0;
+    bouton_appuye = 0;
+
+    //  La requête tient dans la file de réception de simavr, qui délivre les octets au rythme de la liaison
+    avr_cycle_count_t debut = avr->cycle;
+    en_cours = m;
+    phase = PHASE_LECTURE;
+    debut_phase = debut;
+    for(uint16_t i=0; i<taille; i++){
+        avr_raise_irq(uart_entree, requete[i]);
+    }
+    execution(commande_terminee, nom);
+
+    avr_cycle_count_t fin = dernier_octet + CYCLES_OCTET;
+    m->cycles[phase] += fin - debut_phase;
+    m->total = fin - debut;
+    m->statut = reponse[0];
+    m->octets_reponse = recus;
+    en_cours = NULL;
+    phase = PHASE_REPOS;
+    avr_raise_irq(bouton, 1);   // Relâchement
+}
+
+//  app_id_hash de la i-ème entrée (i = 0xFF : application inconnue)
+static void app_id_hash(uint8_t i, uint8_t *hash){
+    for(int j=0; j<TAILLE_APP_ID_HASH; j++){
+        hash[j] = i * 31 + j * 7 + 1;
+    }
+}
+
+static void make_credential(uint8_t i, uint8_t entrees){
+    uint8_t requete[1 + TAILLE_APP_ID_HASH] = {COMMAND_MAKE_CREDENTIAL};
+    app_id_hash(i, requete + 1);
+    commande("MAKE_CREDENTIAL", requete, sizeof(requete), entrees);
+}
+
+static void get_assertion(uint8_t i, const char *nom, uint8_t entrees){
+    uint8_t requete[1 + TAILLE_APP_ID_HASH + TAILLE_DATA_HASH] = {COMMAND_GET_ASSERTION};
+    app_id_hash(i, requete + 1);
+    for(int j=0; j<TAILLE_DATA_HASH; j++){
+        requete[1 + TAILLE_APP_ID_HASH + j] = rand();
+    }
+    commande(nom, requete, sizeof(requete), entrees);
+}
+
+//  LOT signatures sous une seule confirmation
+static void get_assertions(uint8_t i, uint8_t entrees){
+    uint8_t requete[1 + TAILLE_APP_ID_HASH + 1 + LOT * TAILLE_DATA_HASH] = {COMMAND_GET_ASSERTIONS};
+    app_id_hash(i, requete + 1);
+    requete[1 + TAILLE_APP_ID_HASH] = LOT;
+    for(int j=0; j<LOT * TAILLE_DATA_HASH; j++){
+        requete[2 + TAILLE_APP_ID_HASH + j] = rand();
+    }
+    commande("GET_ASSERTIONS", requete, sizeof(requete), entrees);
+}
+
+//  Première page de la liste paginée (4 entrées au plus, sans filtre)
+static void list_page(uint8_t entrees){
+    uint8_t requete[4] = {COMMAND_LIST_PAGE, 0, 4, 0};
+    commande("LIST_PAGE", requete, sizeof(requete), entrees);
+}
+
+static void autre_commande(uint8_t code, const char *nom, uint8_t entrees){
+    commande(nom, &code, 1, entrees);
+}
+
+/*  Pile maximale (octets sous RAMEND écrits au moins une fois) et marge (octets jamais écrits entre les variables
+    globales et la pile), d'après le motif peint au démarrage. Renvoie 0 si aucune zone du motif ne reste : la pile a
+    atteint les variables globales.  */
+static int mesure_pile(uint16_t *pile, uint16_t *marge){
+    uint16_t adresse = avr->ramend;
+    uint16_t suite = 0;
+    while(adresse >= DEBUT_SRAM && suite < MOTIF_MIN){
+        suite = (avr->data[adresse] == MOTIF_PILE) ? suite + 1 : 0;
+        adresse--;
+    }
+    if(suite < MOTIF_MIN){
+        return 0;
+    }
+    *pile = avr->ramend - (adresse + MOTIF_MIN);
+    *marge = 0;
+    for(adresse += MOTIF_MIN; adresse >= DEBUT_SRAM && avr->data[adresse] == MOTIF_PILE; adresse--){
+        (*marge)++;
+    }
+    return 1;
+}
+
+static void ecriture_json(const char *fichier, avr_cycle_count_t demarrage, uint16_t pile, uint16_t marge){
+    printf("{\n");
+    printf("  \"mcu\": \"atmega328p\",\n");
+    printf("  \"f_cpu\": %lu,\n", F_CPU);
+    printf("  \"programme\": \"%s\",\n", fichier);
+    printf("  \"demarrage\": %llu,\n", (unsigned long long)demarrage);
+    printf("  \"pile_max\": %u,\n", pile);
+    printf("  \"marge_pile\": %u,\n", marge);
+    printf("  \"mesures\": [\n");
+    for(int i=0; i<nb_mesures; i++){
+        mesure *m = &mesures[i];
+        printf("    {\"commande\": \"%s\", \"entrees\": %u, \"statut\": %u, \"octets_reponse\": %u, \"cycles\": {",
+               m->commande, m->entrees, m->statut, m->octets_reponse);
+        for(int p=PHASE_LECTURE; p<NB_PHASES; p++){
+            printf("\"%s\": %llu, ", noms_phases[p], (unsigned long long)m->cycles[p]);
+        }
+        printf("\"total\": %llu, \"total_sans_confirmation\": %llu}}%s\n", (unsigned long long)m->total,
+               (unsigned long long)(m->total - m->cycles[PHASE_CONFIRMATION]), i + 1 < nb_mesures ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+static void resume(){
+    fprintf(stderr, "%-24s %7s %6s %9s %9s %9s %12s %9s %9s\n", "commande", "entrées", "statut", "lecture",
+            "recherche", "crypto", "confirmation", "reponse", "total");
+    for(int i=0; i<nb_mesures; i++){
+        mesure *m = &mesures[i];
+        fprintf(stderr, "%-24s %7u %6u %9llu %9llu %9llu %12llu %9llu %9llu\n", m->commande, m->entrees, m->statut,
+                (unsigned long long)m->cycles[PHASE_LECTURE], (unsigned long long)m->cycles[PHASE_RECHERCHE],
+                (unsigned long long)m->cycles[PHASE_CRYPTO], (unsigned long long)m->cycles[PHASE_CONFIRMATION],
+                (unsigned long long)m->cycles[PHASE_REPONSE], (unsigned long long)m->total);
+    }
+}
+
+int main(int argc, char **argv){
+    const char *fichier = argc > 1 ? argv[1] : "main.elf";
+    elf_firmware_t programme;
+
+    memset(&programme, 0, sizeof(programme));
+    if(elf_read_firmware(fichier, &programme) != 0){
+        fprintf(stderr, "ERREUR : lecture de %s impossible\n", fichier);
+        return 1;
+    }
+    programme.frequency = F_CPU;
+    avr = avr_make_mcu_by_name("atmega328p");
+    if(!avr){
+        fprintf(stderr, "ERREUR : simavr ne connaît pas l'atmega328p\n");
+        return 1;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &programme);     // Flash et eeprom (valeurs initiales des variables EEMEM)
+    memset(avr->data + DEBUT_SRAM, MOTIF_PILE, avr->ramend + 1 - DEBUT_SRAM);  // .data et .bss réécrits au démarrage
+
+    //  Liaison série : les octets émis ne sont pas recopiés sur la sortie standard de simavr
+    uint32_t options = 0;
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &options);
+    options &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &options);
+    uart_entree = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), uart_sortie, NULL);
+
+    //  Bouton relâché (entrée à 1)
+    bouton = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), IOPORT_IRQ_PIN2);
+    avr_raise_irq(bouton, 1);
+
+    avr_register_io_write(avr, ADRESSE_GPIOR0, ecriture_gpior0, NULL);
+
+    //  Démarrage : config() (collecte d'entropie comprise) puis remplissage de la réserve de nonces
+    execution(inactive, "démarrage");
+    avr_cycle_count_t demarrage = avr->cycle;
+
+    //  Eeprom vide, puis ajout des entrées une à une jusqu'à la mémoire pleine
+    autre_commande(COMMAND_RESET, "RESET", 0);
+    for(int entrees=0; entrees<=ENTREES_MAX; entrees++){
+        if(entrees > 0){
+            get_assertion(entrees - 1, "GET_ASSERTION", entrees);
+            get_assertions(entrees - 1, entrees);
+        }
+        get_assertion(0xFF, "GET_ASSERTION_INCONNUE", entrees);
+        autre_commande(COMMAND_LIST_CREDENTIALS, "LIST_CREDENTIALS", entrees);
+        list_page(entrees);
+        make_credential(entrees, entrees);      // STORAGE_FULL avec 16 entrées
+    }
+    autre_commande(COMMAND_RESET, "RESET", ENTREES_MAX);
+
+    uint16_t pile, marge;
+    if(!mesure_pile(&pile, &marge)){
+        fprintf(stderr, "ERREUR : la pile a atteint les variables globales\n");
+        return 1;
+    }
+    ecriture_json(fichier, demarrage, pile, marge);
+    resume();
+    fprintf(stderr, "pile maximale : %u octets, marge jamais écrite au-dessus des variables globales : %u octets\n",
+            pile, marge);
+    return 0;
+}
@@ -0,0 +1,240 @@
+/*  Test et banc d'essai hôte des multiplications de points par lots (uECC_mult_batch()) et du moteur SIMD de
+    simd_x86_64.inc : échelles de Montgomery côte à côte, 8 voies AVX-512F ou 4 voies AVX2, limbes de 26 bits.
+    1. Échelle seule (boucle de EccPoint_mult(), coordonnées et scalaires aléatoires ou extrêmes : 0, p - 1) :
+       mêmes coordonnées, bit pour bit, en 8 voies, en 4 voies et avec le code scalaire de uECC.c ;
+    2. uECC_mult_batch() dans chaque mode : k * G égal à la clé publique de uECC_compute_public_key() (table du
+       peigne, calcul indépendant), k * (d * G) égal à (k * d mod n) * G, scalaires extrêmes (1, 2, 2^160 - 1),
+       point hors de la courbe et scalaire nul refusés (résultat nul), lots de tailles quelconques ;
+    3. débit : multiplications par seconde et cycles (rdtsc) dans chaque mode.
+    Les modes que le processeur n'a pas (sélection au chargement) ne sont pas testés.
+    Le programme s'arrête avec un code de retour non nul en cas d'erreur.
+    Compilation et exécution : make test-hote ou make bench-hote (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "../uECC.c"
+
+#if !simd_ladder
+#error "moteur SIMD absent (simd_x86_64.inc, secp160r1 sur x86_64)"
+#endif
+
+#define ECHELLES 200        // Groupes de uECC_MULT_BATCH_GROUP échelles comparées
+#define PRODUITS 300
+#define LOT 1024
+#define DUREE_MESURE 1.0    // Secondes de mesure du débit
+
+static uint32_t graine = 1;
+
+static int rng_bench(uint8_t *destination, unsigned taille){
+    for(unsigned i=0; i<taille; i++){
+        graine ^= graine << 13;
+        graine ^= graine >> 17;
+        graine ^= graine << 5;
+        destination[i] = graine;
+    }
+    return 1;
+}
+
+static const int modes[3] = {8, 4, 0};     // Voies SIMD (0 : échelle scalaire de uECC.c)
+static int lanes_processeur;                // Détectées par simd_x86_64.inc
+static int erreurs = 0;
+
+static void verification(int condition, const char *message){
+    if(!condition){
+        if(erreurs < 10){
+            printf("ECHEC : %s (%d voies)\n", message, simd_lanes);
+        }
+        erreurs++;
+    }
+}
+
+//  Valeur aléatoire modulo p, ou p - 1 une fois sur seize, 0 une fois sur seize
+static void aleatoire_p(uECC_word_t *v){
+    uint8_t tirage;
+    rng_bench(&tirage, 1);
+    if(tirage % 16 == 0){
+        vli_clear(v);
+    } else if(tirage % 16 == 1){
+        vli_set(v, curve_p);
+        v[0] -= 1;
+    } else {
+        do{
+            rng_bench((uint8_t *)v, uECC_BYTES);
+        } while(vli_cmp(curve_p, v) != 1);
+    }
+}
+
+//  1. Échelle sur des coordonnées quelconques (les formules co-Z ne sont que des opérations dans le corps)
+static void essai_echelle(void){
+    static uECC_word_t Rx[4][uECC_MULT_BATCH_GROUP][2][uECC_WORDS], Ry[4][uECC_MULT_BATCH_GROUP][2][uECC_WORDS];
+    uECC_word_t k[uECC_MULT_BATCH_GROUP][uECC_N_WORDS];
+
+    for(int item=0; item<uECC_MULT_BATCH_GROUP; item++){
+        for(int j=0; j<2; j++){
+            aleatoire_p(Rx[0][item][j]);
+            aleatoire_p(Ry[0][item][j]);
+        }
+        rng_bench((uint8_t *)k[item], sizeof(k[item]));
+        k[item][uECC_N_WORDS - 1] &= 3;
+    }
+    for(int m=0; m<3; m++){
+        if(modes[m] > lanes_processeur){
+            continue;
+        }
+        simd_lanes = modes[m];
+        memcpy(Rx[m + 1], Rx[0], sizeof(Rx[0]));
+        memcpy(Ry[m + 1], Ry[0], sizeof(Ry[0]));
+        EccPoint_ladder_batch(Rx[m + 1], Ry[m + 1], k, uECC_MULT_BATCH_GROUP);
+    }
+    //  Le mode scalaire (m = 2) sert de référence
+    for(int m=0; m<2; m++){
+        if(modes[m] <= lanes_processeur){
+            simd_lanes = modes[m];
+            verification(!memcmp(Rx[m + 1], Rx[3], sizeof(Rx[0])) && !memcmp(Ry[m + 1], Ry[3], sizeof(Ry[0])),
+                         "échelle différente du code scalaire");
+        }
+    }
+}
+
+//  Résultat attendu de k * (d * G) : (k * d mod n) * G par uECC_compute_public_key()
+static int attendu(uint8_t resultat[uECC_BYTES * 2], const uint8_t d[uECC_BYTES], const uint8_t k[uECC_BYTES]){
+    uECC_word_t dn[uECC_N_WORDS] = {0}, kn[uECC_N_WORDS] = {0}, produit[uECC_N_WORDS];
+    uint8_t scalaire[uECC_BYTES];
+
+    vli_bytesToNative(dn, d);
+    vli_bytesToNative(kn, k);
+    vli_modMult_n(produit, dn, kn);
+    if(produit[uECC_N_WORDS - 1]){
+        return 0;       // k * d mod n >= 2^160 : pas une clé privée de 20 octets
+    }
+    vli_nativeToBytes(scalaire, produit);
+    return uECC_compute_public_key(scalaire, resultat);
+}
+
+static uint8_t points[LOT][uECC_BYTES * 2], scalaires[LOT][uECC_BYTES], resultats[LOT][uECC_BYTES * 2];
+
+//  2. uECC_mult_batch() sur PRODUITS éléments, dans le mode courant
+static void essai_produits(void){
+    static uint8_t prives[PRODUITS][uECC_BYTES], attendus[PRODUITS][uECC_BYTES * 2];
+    uint8_t zeros[uECC_BYTES * 2] = {0};
+    unsigned valides = 0, tailles[] = {1, 3, 7, 16, 17, 100, PRODUITS};
+
+    graine = 7;
+    for(int i=0; i<PRODUITS; i++){
+        rng_bench(scalaires[i], uECC_BYTES);
+        switch(i % 10){
+        case 0:     // k * G
+            memset(prives[i], 0, uECC_BYTES);
+            prives[i][uECC_BYTES - 1] = 1;
+            break;
+        case 1:     // Scalaires extrêmes
+            memset(scalaires[i], 0, uECC_BYTES);
+            scalaires[i][uECC_BYTES - 1] = 1 + (i / 10) % 2;
+            break;
+        case 2:
+            memset(scalaires[i], 0xFF, uECC_BYTES);
+            break;
+        case 3:     // Scalaire nul
+            memset(scalaires[i], 0, uECC_BYTES);
+            break;
+        }
+        if(i % 10 != 0){
+            uECC_make_key(points[i], prives[i]);
+        } else {
+            uECC_compute_public_key(prives[i], points[i]);
+        }
+        if(i % 10 == 4){    // Point hors de la courbe
+            points[i][uECC_BYTES * 2 - 1] ^= 1;
+        }
+        if(i % 10 == 3 || i % 10 == 4){
+            memset(attendus[i], 0, uECC_BYTES * 2);
+        } else if(!attendu(attendus[i], prives[i], scalaires[i])){
+            memset(scalaires[i], 0, uECC_BYTES);
+            memset(attendus[i], 0, uECC_BYTES * 2);
+        } else {
+            valides++;
+        }
+    }
+    for(unsigned t=0; t<sizeof(tailles)/sizeof(tailles[0]); t++){
+        unsigned n = tailles[t], attendu_n = 0;
+        for(unsigned i=0; i<n; i++){
+            attendu_n += memcmp(attendus[i], zeros, sizeof(zeros)) != 0;
+        }
+        memset(resultats, 0xA5, sizeof(resultats));
+        verification(uECC_mult_batch(points[0], scalaires[0], resultats[0], n) == attendu_n, "nombre de résultats");
+        verification(!memcmp(resultats, attendus, n * uECC_BYTES * 2), "uECC_mult_batch différent de la référence");
+    }
+    verification(uECC_mult_batch(points[0], scalaires[0], resultats[0], 0) == 0, "lot vide");
+}
+
+static double secondes(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(){
+    double reference = 0;
+
+    lanes_processeur = simd_lanes;
+    printf("Processeur : %s\n\n", lanes_processeur == 8 ? "AVX-512F, modes 8 voies, 4 voies et scalaire testés"
+                                  : lanes_processeur == 4 ? "AVX2, modes 4 voies et scalaire testés"
+                                  : "sans AVX2, mode scalaire seul testé");
+    uECC_set_rng(rng_bench);
+
+    //  1. Échelles
+    for(int i=0; i<ECHELLES; i++){
+        essai_echelle();
+    }
+    if(erreurs){
+        printf("ECHEC : %d erreur(s)\n", erreurs);
+        return 1;
+    }
+    printf("Échelle de Montgomery : %d points, mêmes coordonnées dans chaque mode\n", ECHELLES * uECC_MULT_BATCH_GROUP);
+
+    //  2. Produits
+    for(int m=0; m<3; m++){
+        if(modes[m] <= lanes_processeur){
+            simd_lanes = modes[m];
+            essai_produits();
+        }
+    }
+    if(erreurs){
+        printf("ECHEC : %d erreur(s)\n", erreurs);
+        return 1;
+    }
+    printf("uECC_mult_batch : %d produits identiques à uECC_compute_public_key() dans chaque mode\n\n", PRODUITS);
+
+    //  3. Débit
+    for(int i=0; i<LOT; i++){
+        uint8_t prive[uECC_BYTES];
+        uECC_make_key(points[i], prive);
+        rng_bench(scalaires[i], uECC_BYTES);
+    }
+    printf("mode       | multiplications/s | cycles/multiplication | accélération\n");
+    for(int m=2; m>=0; m--){
+        if(modes[m] > lanes_processeur){
+            continue;
+        }
+        simd_lanes = modes[m];
+        long n = 0;
+        double debut = secondes(), duree;
+        uint64_t cycles = __rdtsc();
+        do{
+            uECC_mult_batch(points[0], scalaires[0], resultats[0], LOT);
+            n += LOT;
+            duree = secondes() - debut;
+        } while(duree < DUREE_MESURE);
+        cycles = (__rdtsc() - cycles) / n;
+        if(!modes[m]){
+            reference = n / duree;
+        }
+        printf("%-10s | %17.0f | %21llu | x%.2f\n", modes[m] == 8 ? "AVX-512F" : modes[m] == 4 ? "AVX2" : "scalaire",
+               n / duree, (unsigned long long)cycles, n / duree / reference);
+    }
+    simd_lanes = lanes_processeur;
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*  Test et banc d'essai hôte de uECC_verify() (astuce de Shamir, voir uECC.c), lié à la bibliothèque partagée
+    hote/libuecc.so comme le serait un relying party.
+    1. Un vecteur de référence signé par le module Python 'ecdsa' est accepté, puis refusé s'il est altéré ;
+    2. des signatures de uECC_sign() sur des clés et des hachés aléatoires sont acceptées, et refusées après altération
+       du haché, de r, de s ou de la clé publique ; les clés privées 1, 2 et 3 (Q = G, 2G, 3G : doublements et
+       points opposés dans la table jointe) sont vérifiées à part ;
+    3. débit : vérifications par seconde sur un cœur, et cycles (rdtsc) par opération.
+    Le programme s'arrête avec un code de retour non nul en cas d'erreur.
+    Compilation et exécution : make test-hote ou make bench-hote (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <x86intrin.h>
+
+#include "../uECC.h"
+
+#define VERIFICATIONS 1000
+#define DUREE_MESURE 1.0    // Secondes de mesure du débit
+
+static uint32_t graine = 1;
+
+static int rng_bench(uint8_t *destination, unsigned taille){
+    for(unsigned i=0; i<taille; i++){
+        graine ^= graine << 13;
+        graine ^= graine >> 17;
+        graine ^= graine << 5;
+        destination[i] = graine;
+    }
+    return 1;
+}
+
+//  Vecteur de référence : clé privée 0x1d2c3b4a5968778695a4b3c2d1e0f1e2d3c4b5a6, haché SHA-1 de "yubino", signature
+//  déterministe (RFC 6979) de ecdsa.SigningKey.sign_digest_deterministic(), r et s ramenés à 20 octets
+static const uint8_t reference_cle[40] = {
+    0xE7, 0x1C, 0xE1, 0x55, 0xF8, 0xC1, 0xF6, 0x92, 0xA4, 0x62, 0xF3, 0x38, 0xED, 0x62, 0x78, 0x68, 0xE2, 0xD6, 0x0A, 0x91,
+    0x0A, 0xE8, 0xBE, 0x7C, 0xB6, 0xFC, 0x38, 0x07, 0xD6, 0x78, 0x97, 0x88, 0xEC, 0xEB, 0xF7, 0x69, 0xB2, 0x66, 0x2D, 0x57};
+static const uint8_t reference_hash[20] = {
+    0x67, 0xD2, 0xDC, 0x18, 0x0C, 0xDF, 0xCE, 0x7D, 0xCB, 0xC0, 0x24, 0x49, 0x99, 0x89, 0xCE, 0xA0, 0x80, 0x50, 0xBA, 0x5F};
+static const uint8_t reference_signature[40] = {
+    0x3A, 0x9D, 0xD9, 0x01, 0x8F, 0x86, 0x1D, 0x21, 0x42, 0x34, 0x6E, 0x79, 0xA4, 0x3D, 0x77, 0xBB, 0x18, 0x99, 0xF7, 0x3C,
+    0xFF, 0x3A, 0x8B, 0xC8, 0x4C, 0xFA, 0x2C, 0xC6, 0xB4, 0x38, 0xF0, 0x16, 0x3B, 0x85, 0xBE, 0x75, 0x7C, 0x92, 0xF0, 0x63};
+
+static int erreurs = 0;
+
+static void verification(int condition, const char *message){
+    if(!condition){
+        printf("ECHEC : %s\n", message);
+        erreurs++;
+    }
+}
+
+//  Une signature valide est acceptée, et refusée dès qu'un bit du haché, de r, de s ou de la clé change
+static void acceptation(const uint8_t cle[40], const uint8_t hash[20], const uint8_t signature[40]){
+    uint8_t cle_alteree[40], hash_altere[20], signature_alteree[40];
+    int bit = rand() % 160;
+
+    verification(uECC_verify(cle, hash, signature), "signature valide refusée");
+    memcpy(hash_altere, hash, 20);
+    hash_altere[bit / 8] ^= 1 << (bit % 8);
+    verification(!uECC_verify(cle, hash_altere, signature), "haché altéré accepté");
+    memcpy(signature_alteree, signature, 40);
+    signature_alteree[bit / 8] ^= 1 << (bit % 8);
+    verification(!uECC_verify(cle, hash, signature_alteree), "r altéré accepté");
+    memcpy(signature_alteree, signature, 40);
+    signature_alteree[20 + bit / 8] ^= 1 << (bit % 8);
+    verification(!uECC_verify(cle, hash, signature_alteree), "s altéré accepté");
+    memcpy(cle_alteree, cle, 40);
+    cle_alteree[bit / 4] ^= 1 << (bit % 8);
+    verification(!uECC_verify(cle_alteree, hash, signature), "clé altérée acceptée");
+}
+
+//  Signature par uECC_sign() d'un haché aléatoire avec 'cle_privee', puis acceptation()
+static void signature_aleatoire(const uint8_t cle_privee[20]){
+    uint8_t cle[40], hash[20], signature[40];
+    verification(uECC_compute_public_key(cle_privee, cle), "clé publique");
+    rng_bench(hash, sizeof(hash));
+    verification(uECC_sign(cle_privee, hash, signature), "signature");
+    acceptation(cle, hash, signature);
+}
+
+static double secondes(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(){
+    uint8_t cle[40], cle_privee[20], hash[16][20], signature[16][40];
+    uint8_t zeros[40] = {0};
+
+    uECC_set_rng(rng_bench);
+
+    //  1. Vecteur de référence et cas refusés d'office
+    acceptation(reference_cle, reference_hash, reference_signature);
+    verification(!uECC_verify(reference_cle, reference_hash, zeros), "signature nulle acceptée");
+    verification(!uECC_verify(zeros, reference_hash, reference_signature), "clé nulle acceptée");
+    verification(uECC_valid_public_key(reference_cle) && !uECC_valid_public_key(zeros), "uECC_valid_public_key");
+
+    //  2. Clés privées 1, 2, 3, puis aléatoires
+    for(int k=1; k<=3; k++){
+        memset(cle_privee, 0, sizeof(cle_privee));
+        cle_privee[19] = k;
+        for(int i=0; i<20; i++){
+            signature_aleatoire(cle_privee);
+        }
+    }
+    for(int i=0; i<VERIFICATIONS; i++){
+        uECC_make_key(cle, cle_privee);
+        signature_aleatoire(cle_privee);
+    }
+    if(erreurs){
+        printf("ECHEC : %d erreur(s)\n", erreurs);
+        return 1;
+    }
+    printf("uECC_verify : vecteur de référence et %d signatures vérifiées (et refusées après altération)\n\n",
+           VERIFICATIONS + 60);
+
+    //  3. Débit
+    uECC_make_key(cle, cle_privee);
+    for(int i=0; i<16; i++){
+        rng_bench(hash[i], sizeof(hash[i]));
+        uECC_sign(cle_privee, hash[i], signature[i]);
+    }
+    long n = 0;
+    double debut = secondes(), duree;
+    uint64_t cycles = __rdtsc();
+    do{
+        for(int i=0; i<16; i++){
+            n += uECC_verify(cle, hash[i], signature[i]);
+        }
+        duree = secondes() - debut;
+    } while(duree < DUREE_MESURE);
+    cycles = (__rdtsc() - cycles) / n;
+    printf("uECC_verify : %.0f vérifications/s sur un cœur, %llu cycles par vérification\n", n / duree,
+           (unsigned long long)cycles);
+
+    n = 0;
+    debut = secondes();
+    do{
+        for(int i=0; i<16; i++){
+            n += uECC_sign(cle_privee, hash[i], signature[i]);
+        }
+        duree = secondes() - debut;
+    } while(duree < DUREE_MESURE);
+    printf("uECC_sign   : %.0f signatures/s (référence)\n", n / duree);
+    return 0;
+}
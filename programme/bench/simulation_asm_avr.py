@@ -0,0 +1,218 @@
+"""Simulation, instruction par instruction, des noyaux en boucle de asm_avr.inc sur un processeur AVR (atmega328p)
+écrit ici, sans avr-gcc ni simavr.
+
+Le texte assembleur de vli_mult() (boucle de micro-ecc, 20 octets, déjà éprouvée : elle sert de témoin pour le
+simulateur) et de vli_mult_n() (même boucle sur uECC_N_WORDS = 21 octets, réduction de Barrett modulo n) est lu
+directement dans asm_avr.inc, puis exécuté :
+    1. produits comparés au produit exact (entiers Python) sur des valeurs aléatoires et extrêmes (0, 1, 0xFF...FF),
+       sans écriture hors du résultat, pointeurs X et Y restitués comme le demandent les contraintes de l'asm ;
+    2. cycles du noyau d'après le tableau des instructions de l'atmega328p (sans l'appel ni le prologue de gcc).
+Ce que la simulation ne vérifie pas : l'assemblage par avr-gcc (contraintes, registres choisis) ; la mesure sur la
+carte se fait avec 'make bench/bench_mod_n.hex upload-bench-mod-n'.
+Le programme s'arrête avec un code de retour non nul en cas d'erreur.
+Exécution : python3 bench/simulation_asm_avr.py (dossier 'programme', aussi lancé par make test-hote)."""
+import os
+import random
+import re
+import sys
+
+FICHIER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "asm_avr.inc")
+CONSTANTES = {"uECC_BYTES": 20, "uECC_N_WORDS": 21}
+# Début de chaque noyau dans asm_avr.inc (vli_mult() : la version en boucle, pas les versions déroulées)
+REPERES = {"vli_mult": "#if !asm_mult\n", "vli_mult_n": "static void vli_mult_n("}
+
+# Cycles de l'atmega328p (résumé du jeu d'instructions de la documentation) ; branchements : 1 non pris, 2 pris
+CYCLES = {"ldi": 1, "add": 1, "adc": 1, "sub": 1, "sbc": 1, "mov": 1, "inc": 1, "dec": 1, "cp": 1, "cpi": 1,
+          "eor": 1, "mul": 2, "ld": 2, "st": 2, "adiw": 2, "sbiw": 2, "brlo": 1, "brne": 1}
+
+# Registres donnés aux opérandes nommés (%[k] et %[i] : contrainte "a", r16 à r23)
+OPERANDES = {"r0": 18, "r1": 19, "r2": 20, "zero": 21, "k": 22, "i": 23}
+
+
+def texte_asm(fonction):
+    """Instructions de l'asm de 'fonction' dans asm_avr.inc (chaînes du bloc __asm__, commentaires retirés)"""
+    source = open(FICHIER, encoding="utf-8").read()
+    debut = source.index(REPERES[fonction])
+    bloc = source[source.index("__asm__ volatile (", debut):]
+    bloc = bloc[:bloc.index("\n        :")]
+    bloc = re.sub(r"/\*.*?\*/", "", bloc, flags=re.S)
+    for nom, valeur in CONSTANTES.items():
+        bloc = bloc.replace('" STR(%s) "' % nom, str(valeur))
+    instructions = []
+    for chaine in re.findall(r'"((?:[^"\\]|\\.)*)"', bloc):
+        ligne = chaine.replace("\\n", "").replace("\\t", "").strip()
+        if ligne:
+            instructions.append(ligne)
+    return instructions
+
+
+class Avr:
+    def __init__(self, instructions):
+        self.programme = []
+        self.etiquettes = []    # (numéro, indice de l'instruction suivante)
+        for ligne in instructions:
+            m = re.fullmatch(r"(\d+):", ligne)
+            if m:
+                self.etiquettes.append((m.group(1), len(self.programme)))
+                continue
+            mnemonique, _, reste = ligne.partition(" ")
+            operandes = [o.strip() for o in reste.split(",")] if reste.strip() else []
+            self.programme.append((mnemonique, operandes, len(self.etiquettes)))
+        self.r = [0] * 32
+        self.memoire = bytearray(2048)
+        self.c = self.z = 0
+        self.cycles = 0
+
+    def registre(self, operande):
+        m = re.fullmatch(r"%\[(\w+)\]", operande)
+        if m:
+            return OPERANDES[m.group(1)]
+        m = re.fullmatch(r"r(\d+)", operande)
+        if m:
+            return int(m.group(1))
+        raise ValueError("opérande inconnu : " + operande)
+
+    def paire(self, n):
+        return self.r[n] | (self.r[n + 1] << 8)
+
+    def fixe_paire(self, n, valeur):
+        valeur &= 0xFFFF
+        self.r[n], self.r[n + 1] = valeur & 0xFF, valeur >> 8
+
+    def cible(self, etiquette, position):
+        # "2b" : dernière étiquette 2 définie avant l'instruction
+        numero = etiquette[:-1]
+        candidates = [i for (e, i), rang in zip(self.etiquettes, range(len(self.etiquettes)))
+                      if e == numero and rang < self.programme[position][2]]
+        return candidates[-1]
+
+    def soustraction(self, a, b, retenue):
+        resultat = a - b - retenue
+        self.c = 1 if resultat < 0 else 0
+        return resultat & 0xFF
+
+    def execute(self):
+        pc = 0
+        while pc < len(self.programme):
+            mnemonique, op, _ = self.programme[pc]
+            self.cycles += CYCLES[mnemonique]
+            suivant = pc + 1
+            if mnemonique == "ldi":
+                self.r[self.registre(op[0])] = int(op[1], 0) & 0xFF
+            elif mnemonique in ("add", "adc"):
+                d, s = self.registre(op[0]), self.registre(op[1])
+                somme = self.r[d] + self.r[s] + (self.c if mnemonique == "adc" else 0)
+                self.c = somme >> 8
+                self.r[d] = somme & 0xFF
+                self.z = int(self.r[d] == 0)
+            elif mnemonique in ("sub", "sbc", "cp", "cpi"):
+                d = self.registre(op[0])
+                b = int(op[1], 0) if mnemonique == "cpi" else self.r[self.registre(op[1])]
+                z_avant = self.z
+                resultat = self.soustraction(self.r[d], b, self.c if mnemonique == "sbc" else 0)
+                self.z = int(resultat == 0) & (z_avant if mnemonique == "sbc" else 1)
+                if mnemonique in ("sub", "sbc"):
+                    self.r[d] = resultat
+            elif mnemonique == "mov":
+                self.r[self.registre(op[0])] = self.r[self.registre(op[1])]
+            elif mnemonique in ("inc", "dec"):
+                d = self.registre(op[0])
+                self.r[d] = (self.r[d] + (1 if mnemonique == "inc" else -1)) & 0xFF
+                self.z = int(self.r[d] == 0)
+            elif mnemonique == "eor":
+                d = self.registre(op[0])
+                self.r[d] ^= self.r[self.registre(op[1])]
+                self.z = int(self.r[d] == 0)
+            elif mnemonique == "mul":
+                produit = self.r[self.registre(op[0])] * self.r[self.registre(op[1])]
+                self.r[0], self.r[1] = produit & 0xFF, produit >> 8
+                self.c = produit >> 15
+                self.z = int(produit == 0)
+            elif mnemonique == "ld":
+                d, pointeur = self.registre(op[0]), op[1]
+                base = {"x": 26, "y": 28, "z": 30}[pointeur.strip("+-")]
+                adresse = self.paire(base)
+                if pointeur.startswith("-"):
+                    adresse -= 1
+                    self.fixe_paire(base, adresse)
+                self.r[d] = self.memoire[adresse]
+                if pointeur.endswith("+"):
+                    self.fixe_paire(base, adresse + 1)
+            elif mnemonique == "st":
+                pointeur = op[0]
+                base = {"x": 26, "y": 28, "z": 30}[pointeur.strip("+-")]
+                adresse = self.paire(base)
+                self.memoire[adresse] = self.r[self.registre(op[1])]
+                if pointeur.endswith("+"):
+                    self.fixe_paire(base, adresse + 1)
+            elif mnemonique in ("adiw", "sbiw"):
+                d = self.registre(op[0])
+                valeur = self.paire(d) + (int(op[1], 0) if mnemonique == "adiw" else -int(op[1], 0))
+                self.c = int(valeur < 0 or valeur > 0xFFFF)
+                self.fixe_paire(d, valeur)
+            elif mnemonique in ("brlo", "brne"):
+                if (self.c if mnemonique == "brlo" else not self.z):
+                    suivant = self.cible(op[0], pc)
+                    self.cycles += 1
+            else:
+                raise ValueError("instruction non simulée : " + mnemonique)
+            pc = suivant
+
+
+erreurs = 0
+
+
+def verification(condition, message):
+    global erreurs
+    if not condition:
+        if erreurs < 10:
+            print("ERREUR : " + message)
+        erreurs += 1
+
+
+def essai(instructions, taille, gauche, droite):
+    """Produit de gauche et droite (entiers de 'taille' octets) par le noyau ; renvoie le nombre de cycles"""
+    avr = Avr(instructions)
+    adresse_gauche, adresse_droite, adresse_resultat = 0x100, 0x200, 0x300
+    avr.memoire[adresse_gauche:adresse_gauche + taille] = gauche.to_bytes(taille, "little")
+    avr.memoire[adresse_droite:adresse_droite + taille] = droite.to_bytes(taille, "little")
+    avr.memoire[adresse_resultat - 16:adresse_resultat] = bytes([0xA5] * 16)
+    avr.memoire[adresse_resultat + 2 * taille:adresse_resultat + 2 * taille + 16] = bytes([0xA5] * 16)
+    avr.fixe_paire(26, adresse_gauche)     # "+x" (left)
+    avr.fixe_paire(28, adresse_droite)     # "y" (right), à restituer
+    avr.fixe_paire(30, adresse_resultat)   # "+z" (result)
+    for nom in ("r0", "r1", "r2", "zero"):
+        avr.r[OPERANDES[nom]] = 0          # Variables initialisées à 0 dans la fonction C
+    avr.execute()
+    obtenu = int.from_bytes(avr.memoire[adresse_resultat:adresse_resultat + 2 * taille], "little")
+    verification(obtenu == gauche * droite, "produit faux sur %d octets : %x * %x" % (taille, gauche, droite))
+    verification(avr.memoire[adresse_resultat - 16:adresse_resultat] == bytes([0xA5] * 16) and
+                 avr.memoire[adresse_resultat + 2 * taille:adresse_resultat + 2 * taille + 16] == bytes([0xA5] * 16),
+                 "écriture hors du résultat")
+    verification(avr.paire(28) == adresse_droite, "Y (pointeur de pile de gcc) non restitué")
+    verification(avr.r[1] == 0, "r1 (registre nul de gcc) non remis à 0")
+    return avr.cycles
+
+
+def main():
+    random.seed(1)
+    print("noyau          | octets | produits vérifiés | cycles (min - max)")
+    for fonction, taille in (("vli_mult", 20), ("vli_mult_n", 21)):
+        instructions = texte_asm(fonction)
+        maximum = (1 << (8 * taille)) - 1
+        valeurs = [0, 1, maximum, 1 << (8 * taille - 1)] + [random.getrandbits(8 * taille) for _ in range(300)]
+        cycles = []
+        for a in valeurs[:4]:
+            for b in valeurs[:4]:
+                cycles.append(essai(instructions, taille, a, b))
+        for a, b in zip(valeurs[4::2], valeurs[5::2]):
+            cycles.append(essai(instructions, taille, a, b))
+        print("%-14s | %6d | %17d | %d - %d" % (fonction, taille, len(cycles), min(cycles), max(cycles)))
+    if erreurs:
+        print("ERREUR : %d erreur(s)" % erreurs)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
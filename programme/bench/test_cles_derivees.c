@@ -0,0 +1,172 @@
+/*  Test hôte du profil 'clés dérivées' (CLES_DERIVEES dans main.c, make CLES_DERIVEES=1 pour la carte) :
+    1. SHA-256 et HMAC-SHA256 sur les vecteurs de la FIPS 180-4 et de la RFC 4231 ;
+    2. 40 applications, plus que les 16 entrées de l'eeprom : MAKE_CREDENTIAL puis GET_ASSERTION répondent avec le
+       même credential_id, la clé publique est celle de la clé privée dérivée, et rien n'est écrit dans l'eeprom ;
+    3. la clé maître est relue au redémarrage (mêmes clés), et RESET la remplace : une seule écriture, des 16 octets
+       moins ceux que la nouvelle clé a en commun avec l'ancienne (ecriture_eeprom() les saute), puis des credential_id
+       différents ;
+    4. deux appareils neufs (eeprom effacée) tirent des clés maîtres différentes.
+    Le test échoue avec un code de retour non nul. À lancer avec 'make test-hote' (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CLES_DERIVEES 1
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+#define APPLICATIONS 40
+#define TAILLE_REPONSE (1 + TAILLE_CREDENTIAL_ID + TAILLE_CLE_PUBLIC)
+
+static int echecs = 0;
+
+static void verification(int condition, const char *message){
+    if(!condition){
+        printf("ECHEC : %s\n", message);
+        echecs++;
+    }
+}
+
+static void hash_attendu(const uint8_t *hash, const char *hexa, const char *nom){
+    char obtenu[2 * SHA256_TAILLE_HASH + 1];
+    for(int i=0; i<SHA256_TAILLE_HASH; i++){
+        sprintf(obtenu + 2 * i, "%02x", hash[i]);
+    }
+    verification(!strcmp(obtenu, hexa), nom);
+}
+
+static void vecteurs(){
+    sha256_contexte contexte;
+    uint8_t hash[SHA256_TAILLE_HASH], cle[20];
+    const char *deux_blocs = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+    sha256_init(&contexte);
+    sha256_ajout(&contexte, (const uint8_t *)"abc", 3);
+    sha256_fin(&contexte, hash);
+    hash_attendu(hash, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", "SHA-256 'abc'");
+
+    sha256_init(&contexte);
+    sha256_ajout(&contexte, (const uint8_t *)deux_blocs, strlen(deux_blocs));
+    sha256_fin(&contexte, hash);
+    hash_attendu(hash, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", "SHA-256 56 octets");
+
+    memset(cle, 0x0b, sizeof(cle));
+    hmac_sha256_init(&contexte, cle, sizeof(cle));
+    sha256_ajout(&contexte, (const uint8_t *)"Hi There", 8);
+    hmac_sha256_fin(&contexte, cle, sizeof(cle), hash);
+    hash_attendu(hash, "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7", "HMAC RFC 4231 cas 1");
+
+    hmac_sha256_init(&contexte, (const uint8_t *)"Jefe", 4);
+    sha256_ajout(&contexte, (const uint8_t *)"what do ya want for nothing?", 28);
+    hmac_sha256_fin(&contexte, (const uint8_t *)"Jefe", 4, hash);
+    hash_attendu(hash, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", "HMAC RFC 4231 cas 2");
+}
+
+//  Requête complète traitée par la boucle principale, l'utilisateur appuie 100 ms après son arrivée
+static uint16_t requete(const uint8_t *octets, uint16_t taille, uint8_t *reponse){
+    hote_uart_envoi(octets, taille);
+    while(requete_en_attente == AUCUNE_REQUETE){
+        tour_boucle();
+    }
+    hote_bouton_programme(hote_horloge_ns + 100000000ull, 1);
+    while(requete_en_attente != AUCUNE_REQUETE){
+        tour_boucle();
+    }
+    UART__vidage();
+    hote_bouton(0);
+    _delay_ms(50);      // Relâchement pris en compte par le filtrage
+    return hote_uart_reception(reponse, TAILLE_REPONSE + 1);
+}
+
+static uint16_t make_credential_test(const uint8_t *app_id_hash, uint8_t *reponse){
+    uint8_t octets[1 + TAILLE_APP_ID_HASH] = {COMMAND_MAKE_CREDENTIAL};
+    memcpy(octets + 1, app_id_hash, TAILLE_APP_ID_HASH);
+    return requete(octets, sizeof(octets), reponse);
+}
+
+static uint16_t get_assertion_test(const uint8_t *app_id_hash, uint8_t *reponse){
+    uint8_t octets[1 + TAILLE_APP_ID_HASH + TAILLE_DATA_HASH] = {COMMAND_GET_ASSERTION};
+    memcpy(octets + 1, app_id_hash, TAILLE_APP_ID_HASH);
+    for(int i=0; i<TAILLE_DATA_HASH; i++){
+        octets[1 + TAILLE_APP_ID_HASH + i] = rand();
+    }
+    return requete(octets, sizeof(octets), reponse);
+}
+
+int main(){
+    uint8_t app_id_hash[APPLICATIONS][TAILLE_APP_ID_HASH];
+    uint8_t credential_ids[APPLICATIONS][TAILLE_CREDENTIAL_ID];
+    uint8_t reponse[TAILLE_REPONSE + 1], assertion[TAILLE_REPONSE + 1];
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID], private_key[TAILLE_CLE_PRIVE], public_key[TAILLE_CLE_PUBLIC];
+    uint8_t sauvegarde[TAILLE_CLE_MAITRE];
+
+    vecteurs();
+
+    //  Premier démarrage : eeprom vierge, tirage de la clé maître
+    hote_eeprom_effacement();
+    config();
+
+    //  2. Applications au-delà de la capacité de l'eeprom, sans écriture
+    hote_compteurs_raz();
+    for(int a=0; a<APPLICATIONS; a++){
+        for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+            app_id_hash[a][i] = rand();
+        }
+        uint16_t taille = make_credential_test(app_id_hash[a], reponse);
+        verification(taille == TAILLE_REPONSE && reponse[0] == STATUS_OK, "MAKE_CREDENTIAL");
+        memcpy(credential_ids[a], reponse + 1, TAILLE_CREDENTIAL_ID);
+
+        verification(derivation_cle(app_id_hash[a], credential_id, private_key)
+                     && uECC_compute_public_key(private_key, public_key), "dérivation");
+        verification(!memcmp(credential_id, reponse + 1, TAILLE_CREDENTIAL_ID)
+                     && !memcmp(public_key, reponse + 1 + TAILLE_CREDENTIAL_ID, TAILLE_CLE_PUBLIC),
+                     "clé publique ou credential_id différents de la dérivation");
+
+        taille = get_assertion_test(app_id_hash[a], assertion);
+        verification(taille == 1 + TAILLE_CREDENTIAL_ID + TAILLE_SIGNATURE && assertion[0] == STATUS_OK
+                     && !memcmp(assertion + 1, credential_ids[a], TAILLE_CREDENTIAL_ID), "GET_ASSERTION");
+    }
+    printf("%d applications : %u octets écrits dans l'eeprom\n", APPLICATIONS, hote_eeprom_ecritures);
+    verification(hote_eeprom_ecritures == 0, "écriture dans l'eeprom");
+
+    //  3. Redémarrage : même clé maître, mêmes clés
+    memcpy(sauvegarde, cle_maitre, TAILLE_CLE_MAITRE);
+    memset(cle_maitre, 0, TAILLE_CLE_MAITRE);
+    chargement_cle_maitre();
+    verification(!memcmp(sauvegarde, cle_maitre, TAILLE_CLE_MAITRE), "clé maître relue");
+    make_credential_test(app_id_hash[0], reponse);
+    verification(!memcmp(reponse + 1, credential_ids[0], TAILLE_CREDENTIAL_ID), "credential_id après redémarrage");
+
+    //  RESET : nouvelle clé maître
+    uint8_t reset = COMMAND_RESET;
+    hote_compteurs_raz();
+    verification(requete(&reset, 1, reponse) == 1 && reponse[0] == STATUS_OK, "RESET");
+    unsigned differents = 0;
+    for(int i=0; i<TAILLE_CLE_MAITRE; i++){
+        differents += (cle_maitre[i] != sauvegarde[i]);
+    }
+    printf("RESET : %u octets écrits dans l'eeprom\n", hote_eeprom_ecritures);
+    verification(hote_eeprom_ecritures == differents, "RESET : une seule écriture de la clé maître");
+    make_credential_test(app_id_hash[0], reponse);
+    verification(memcmp(reponse + 1, credential_ids[0], TAILLE_CREDENTIAL_ID), "credential_id inchangé après RESET");
+
+    //  4. Deux premiers démarrages (même compteur de démarrages) : clés maîtres différentes
+    for(int a=0; a<2; a++){
+        hote_eeprom_effacement();
+        initialisation_aleatoire();
+        chargement_cle_maitre();
+        if(a == 0){
+            memcpy(sauvegarde, cle_maitre, TAILLE_CLE_MAITRE);
+        }
+    }
+    verification(memcmp(sauvegarde, cle_maitre, TAILLE_CLE_MAITRE), "même clé maître sur deux appareils neufs");
+
+    if(echecs){
+        printf("ECHEC : %d erreur(s)\n", echecs);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
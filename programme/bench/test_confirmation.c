@@ -0,0 +1,115 @@
+/*  Test hôte de GET_ASSERTION avec la signature calculée pendant la demande de confirmation :
+    1. l'utilisateur appuie au bout de 2 secondes : la réponse complète (57 octets) doit partir dans les
+       DELAI_MAX_MS millisecondes qui suivent l'appui (filtrage du bouton et émission compris) ;
+    2. l'utilisateur n'appuie pas : au bout des 10 secondes, seule la réponse STATUS_ERR_APPROVAL sort ;
+    3. entrée inconnue et appui : STATUS_ERR_NOT_FOUND, toujours après l'appui.
+    La requête est traitée par la boucle principale (tour_boucle()), qui ne doit pas préparer de nonce pendant l'attente
+    (sur l'AVR, un nonce retarderait la réponse à l'appui de plusieurs centaines de millisecondes, ce que l'horloge
+    virtuelle ne voit pas), mais doit remplir la réserve une fois la réponse envoyée.
+    Le bouton est appuyé à un instant donné de l'horloge virtuelle (hote_bouton_programme()), la LED doit être éteinte
+    à la fin. Le test échoue avec un code de retour non nul. À lancer avec 'make test-hote' (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+#define TAILLE_REPONSE (1 + TAILLE_CREDENTIAL_ID + TAILLE_SIGNATURE)
+#define APPUI_MS 2000
+#define DELAI_MAX_MS 20     // 10 ms de filtrage du bouton + 5 ms d'émission à 115200 bauds, arrondi
+
+//  Requête GET_ASSERTION, appui éventuel 'appui_ms' ms après son arrivée. Renvoie la taille de la réponse
+static uint16_t requete(const uint8_t *app_id_hash, int appui_ms, uint8_t *reponse, uint64_t *duree_apres_appui){
+    uint8_t donnees[TAILLE_APP_ID_HASH + TAILLE_DATA_HASH];
+    memcpy(donnees, app_id_hash, TAILLE_APP_ID_HASH);
+    for(int i=0; i<TAILLE_DATA_HASH; i++){
+        donnees[TAILLE_APP_ID_HASH + i] = rand();
+    }
+    hote_uart_envoi(donnees, sizeof(donnees));
+
+    uint64_t appui = hote_horloge_ns + (uint64_t)appui_ms * 1000000;
+    if(appui_ms >= 0){
+        hote_bouton_programme(appui, 1);
+    }
+    get_assertion();
+    while(requete_en_attente != AUCUNE_REQUETE){    // Boucle principale jusqu'à la réponse
+        tour_boucle();
+    }
+    UART__vidage();
+    *duree_apres_appui = hote_horloge_ns - appui;
+
+    hote_bouton(0);
+    _delay_ms(50);      // Relâchement pris en compte par le filtrage
+    return hote_uart_reception(reponse, TAILLE_REPONSE + 1);
+}
+
+int main(){
+    uint8_t app_id_hash[TAILLE_APP_ID_HASH], inconnu[TAILLE_APP_ID_HASH];
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID], private_key[TAILLE_CLE_PRIVE], public_key[TAILLE_CLE_PUBLIC];
+    uint8_t reponse[TAILLE_REPONSE + 1];
+    uint64_t duree;
+    uint16_t taille;
+    int echecs = 0;
+
+    hote_eeprom_effacement();
+    config();
+    for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+        app_id_hash[i] = rand();
+        inconnu[i] = rand();
+    }
+    memcpy(credential_id, app_id_hash, TAILLE_CREDENTIAL_ID);
+    uECC_make_key(public_key, private_key);
+    sauvegarde_entree_eeprom(app_id_hash, credential_id, private_key);
+
+    //  1. Appui au bout de 2 s
+    taille = requete(app_id_hash, APPUI_MS, reponse, &duree);
+    printf("appui          : %u octets, statut %u, réponse %.3f ms après l'appui\n",
+           taille, taille ? reponse[0] : 0xFF, duree / 1000000.0);
+    if(taille != TAILLE_REPONSE || reponse[0] != STATUS_OK || memcmp(reponse + 1, credential_id, TAILLE_CREDENTIAL_ID)
+       || duree > (uint64_t)DELAI_MAX_MS * 1000000){
+        echecs++;
+    }
+    if(reserve_compteur != 0){
+        printf("nonce préparé pendant la demande de confirmation (%u)\n", reserve_compteur);
+        echecs++;
+    }
+    for(int i=0; i<TAILLE_RESERVE; i++){
+        tour_boucle();
+    }
+    if(reserve_compteur != TAILLE_RESERVE){
+        printf("réserve de nonces non remplie après la réponse (%u)\n", reserve_compteur);
+        echecs++;
+    }
+
+    //  2. Pas d'appui
+    uint64_t debut = hote_horloge_ns;
+    taille = requete(app_id_hash, -1, reponse, &duree);
+    printf("pas d'appui    : %u octets, statut %u, au bout de %.3f s\n",
+           taille, taille ? reponse[0] : 0xFF, (hote_horloge_ns - debut) / 1e9);
+    if(taille != 1 || reponse[0] != STATUS_ERR_APPROVAL){
+        echecs++;
+    }
+
+    //  3. Entrée inconnue
+    taille = requete(inconnu, APPUI_MS, reponse, &duree);
+    printf("entrée inconnue: %u octets, statut %u, réponse %.3f ms après l'appui\n",
+           taille, taille ? reponse[0] : 0xFF, duree / 1000000.0);
+    if(taille != 1 || reponse[0] != STATUS_ERR_NOT_FOUND || duree > (uint64_t)DELAI_MAX_MS * 1000000){
+        echecs++;
+    }
+
+    if(PORTD & (1 << LED_PIN)){
+        printf("LED restée allumée\n");
+        echecs++;
+    }
+
+    if(echecs){
+        printf("ECHEC : %d erreur(s)\n", echecs);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
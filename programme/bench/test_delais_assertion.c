@@ -0,0 +1,95 @@
+/*  Test hôte : la durée d'un GET_ASSERTION ne doit pas dépendre du nombre d'entrées enregistrées.
+    Le programme est exécuté sur le matériel simulé (dossier 'hote') : l'horloge est virtuelle (délais, liaison série
+    à 115200 bauds), le bouton est appuyé dès le début de la demande de confirmation. Pour chaque nombre d'entrées (de 1 à MAX_ENTREES),
+    on mesure la durée virtuelle de get_assertion() et le nombre d'octets lus dans l'eeprom ; le test échoue si l'une
+    de ces valeurs varie. À lancer avec 'make test-hote' (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+#define TAILLE_REPONSE (1 + TAILLE_CREDENTIAL_ID + TAILLE_SIGNATURE)
+
+int main(){
+    uint8_t app_id_hash[TAILLE_APP_ID_HASH];
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID];
+    uint8_t private_key[TAILLE_CLE_PRIVE];
+    uint8_t public_key[TAILLE_CLE_PUBLIC];
+    uint8_t requete[1 + TAILLE_APP_ID_HASH + TAILLE_DATA_HASH];
+    uint8_t reponse[TAILLE_REPONSE + 1];
+    uint64_t duree_reference = 0;
+    uint32_t lectures_reference = 0;
+    int echecs = 0;
+
+    srand(1);
+    config();
+    hote_eeprom_effacement();
+    chargement_magasin();
+
+    printf("entrees | duree GET_ASSERTION (ms) | octets lus dans l'eeprom\n");
+    for(int n=1; n<=MAX_ENTREES; n++){
+        // Nouvelle entrée : c'est elle qu'on recherche (dernière position, pire cas d'un parcours)
+        for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+            app_id_hash[i] = rand();
+        }
+        memcpy(credential_id, app_id_hash, TAILLE_CREDENTIAL_ID);
+        uECC_make_key(public_key, private_key);
+        sauvegarde_entree_eeprom(app_id_hash, credential_id, private_key);
+
+        // Requête GET_ASSERTION (l'octet de commande est lu par main(), pas par get_assertion())
+        memcpy(requete + 1, app_id_hash, TAILLE_APP_ID_HASH);
+        for(int i=0; i<TAILLE_DATA_HASH; i++){
+            requete[1 + TAILLE_APP_ID_HASH + i] = rand();
+        }
+        //  Départ aligné sur une interruption du Timer2 : le bouton est lu toutes les ms, la durée mesurée ne doit pas
+        //  dépendre de la phase de cette horloge
+        uint16_t ms = millisecondes;
+        cli();
+        while(millisecondes == ms){
+            veille();
+        }
+        sei();
+        hote_uart_envoi(requete + 1, sizeof(requete) - 1);
+
+        bouton_etat = 1;
+        bouton_compteur = 0;
+        bouton_appuie = 0;
+        hote_bouton(1);
+        hote_compteurs_raz();
+        uint64_t debut = hote_horloge_ns;
+        get_assertion();
+        while(requete_en_attente != AUCUNE_REQUETE){    // Boucle principale jusqu'à la réponse
+            tour_boucle();
+        }
+        UART__vidage();
+        uint64_t duree = hote_horloge_ns - debut;
+        uint32_t lectures = hote_eeprom_lectures;
+        hote_bouton(0);
+
+        uint16_t taille = hote_uart_reception(reponse, sizeof(reponse));
+        if(taille != TAILLE_REPONSE || reponse[0] != STATUS_OK){
+            printf("%7d : réponse invalide (%u octets, statut %u)\n", n, taille, taille ? reponse[0] : 0xFF);
+            echecs++;
+        }
+
+        printf("%7d | %24.3f | %24u\n", n, duree / 1000000.0, lectures);
+        if(n == 1){
+            duree_reference = duree;
+            lectures_reference = lectures;
+        }
+        else if(duree != duree_reference || lectures != lectures_reference){
+            echecs++;
+        }
+    }
+
+    if(echecs){
+        printf("ECHEC : la durée de GET_ASSERTION dépend du nombre d'entrées\n");
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*  Test hôte du profil 'présence' (fenêtre de présence de 5 s, par application) :
+    1. GET_ASSERTION confirmé par un appui ouvre la fenêtre : les GET_ASSERTION et MAKE_CREDENTIAL suivants pour la
+       même application répondent aussitôt, sans appui et sans allumer la LED ;
+    2. une autre application demande toujours un appui, qui déplace la fenêtre sur elle ;
+    3. la fenêtre se referme au bout de 5 s (décomptée par le Timer2) : sans appui, STATUS_ERR_APPROVAL ;
+    4. RESET ferme la fenêtre : la commande suivante demande un appui.
+    Le test échoue avec un code de retour non nul. À lancer avec 'make test-hote' (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DUREE_PRESENCE 5
+#define PRESENCE_PAR_APPLICATION 1
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+#define TAILLE_REPONSE (1 + TAILLE_CREDENTIAL_ID + TAILLE_CLE_PUBLIC)     // La plus longue : MAKE_CREDENTIAL
+#define APPUI_MS 1000
+#define DELAI_MAX_MS 20     // Réponse sans appui : calculs et émission, arrondi
+
+static int echecs = 0;
+static uint8_t led_allumee;     // LED allumée pendant la requête
+
+static void verification(int condition, const char *message){
+    if(!condition){
+        printf("ECHEC : %s\n", message);
+        echecs++;
+    }
+}
+
+/*  Requête 'commande' (GET_ASSERTION, MAKE_CREDENTIAL ou RESET) pour 'app_id_hash', appui éventuel 'appui_ms' ms après
+    son arrivée (-1 : pas d'appui). Renvoie le statut de la réponse, et sa durée en ms dans 'duree_ms'  */
+static uint8_t requete(uint8_t commande, const uint8_t *app_id_hash, int appui_ms, double *duree_ms){
+    uint8_t donnees[TAILLE_APP_ID_HASH + TAILLE_DATA_HASH], reponse[TAILLE_REPONSE + 1];
+    uint64_t debut = hote_horloge_ns;
+    memcpy(donnees, app_id_hash, TAILLE_APP_ID_HASH);
+    for(int i=0; i<TAILLE_DATA_HASH; i++){
+        donnees[TAILLE_APP_ID_HASH + i] = rand();
+    }
+    if(commande == COMMAND_GET_ASSERTION){
+        hote_uart_envoi(donnees, TAILLE_APP_ID_HASH + TAILLE_DATA_HASH);
+    }
+    else if(commande == COMMAND_MAKE_CREDENTIAL){
+        hote_uart_envoi(donnees, TAILLE_APP_ID_HASH);
+    }
+    if(appui_ms >= 0){
+        hote_bouton_programme(debut + (uint64_t)appui_ms * 1000000, 1);
+    }
+
+    if(commande == COMMAND_GET_ASSERTION){
+        get_assertion();
+    }
+    else if(commande == COMMAND_MAKE_CREDENTIAL){
+        make_credential();
+    }
+    else{
+        command_reset();
+    }
+    led_allumee = 0;
+    while(requete_en_attente != AUCUNE_REQUETE){    // Boucle principale jusqu'à la réponse
+        led_allumee |= (PORTD & (1 << LED_PIN)) != 0;
+        tour_boucle();
+    }
+    UART__vidage();
+    *duree_ms = (hote_horloge_ns - debut) / 1e6;
+
+    hote_bouton(0);
+    _delay_ms(50);      // Relâchement pris en compte par le filtrage
+    hote_uart_reception(reponse, sizeof(reponse));
+    return reponse[0];
+}
+
+int main(){
+    uint8_t app_a[TAILLE_APP_ID_HASH], app_b[TAILLE_APP_ID_HASH];
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID], private_key[TAILLE_CLE_PRIVE], public_key[TAILLE_CLE_PUBLIC];
+    double duree;
+    uint8_t statut;
+
+    hote_eeprom_effacement();
+    config();
+    for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+        app_a[i] = rand();
+        app_b[i] = rand();
+    }
+    uECC_make_key(public_key, private_key);
+    memcpy(credential_id, app_a, TAILLE_CREDENTIAL_ID);
+    sauvegarde_entree_eeprom(app_a, credential_id, private_key);
+    memcpy(credential_id, app_b, TAILLE_CREDENTIAL_ID);
+    sauvegarde_entree_eeprom(app_b, credential_id, private_key);
+
+    //  1. Appui, puis deux commandes sans appui dans la fenêtre
+    statut = requete(COMMAND_GET_ASSERTION, app_a, APPUI_MS, &duree);
+    verification(statut == STATUS_OK && duree >= APPUI_MS, "première assertion confirmée par l'appui");
+    statut = requete(COMMAND_GET_ASSERTION, app_a, -1, &duree);
+    printf("assertion dans la fenêtre : statut %u en %.3f ms, LED %s\n", statut, duree,
+           led_allumee ? "allumée" : "éteinte");
+    verification(statut == STATUS_OK && duree <= DELAI_MAX_MS && !led_allumee, "assertion sans appui dans la fenêtre");
+    statut = requete(COMMAND_MAKE_CREDENTIAL, app_a, -1, &duree);
+    printf("enregistrement dans la fenêtre : statut %u en %.3f ms (écriture de la clé comprise)\n", statut, duree);
+    verification(statut == STATUS_OK && !led_allumee, "enregistrement sans appui dans la fenêtre");
+
+    //  2. Autre application : appui demandé, puis fenêtre sur elle
+    statut = requete(COMMAND_GET_ASSERTION, app_b, APPUI_MS, &duree);
+    verification(statut == STATUS_OK && duree >= APPUI_MS && led_allumee, "autre application confirmée par l'appui");
+    statut = requete(COMMAND_GET_ASSERTION, app_b, -1, &duree);
+    verification(statut == STATUS_OK && duree <= DELAI_MAX_MS, "fenêtre déplacée sur l'autre application");
+
+    //  3. Fenêtre refermée au bout de 5 s
+    _delay_ms(DUREE_PRESENCE * 1000);
+    statut = requete(COMMAND_GET_ASSERTION, app_b, -1, &duree);
+    printf("assertion après la fenêtre : statut %u au bout de %.3f s\n", statut, duree / 1000);
+    verification(statut == STATUS_ERR_APPROVAL, "fenêtre refermée");
+
+    //  4. RESET ferme la fenêtre
+    statut = requete(COMMAND_GET_ASSERTION, app_a, APPUI_MS, &duree);
+    verification(statut == STATUS_OK, "assertion confirmée avant RESET");
+    statut = requete(COMMAND_RESET, app_a, APPUI_MS, &duree);
+    verification(statut == STATUS_OK, "RESET confirmé");
+    statut = requete(COMMAND_MAKE_CREDENTIAL, app_a, -1, &duree);
+    verification(statut == STATUS_ERR_APPROVAL, "fenêtre fermée par RESET");
+
+    if(PORTD & (1 << LED_PIN)){
+        printf("LED restée allumée\n");
+        echecs++;
+    }
+    if(echecs){
+        printf("ECHEC : %d erreur(s)\n", echecs);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
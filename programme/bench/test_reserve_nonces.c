@@ -0,0 +1,137 @@
+/*  Test hôte de la réserve de nonces (signature en deux temps, partie 6 de main.c) :
+    1. une signature faite avec un nonce de uECC_make_nonce() est identique à celle de uECC_sign() quand la fonction
+       aléatoire donne les mêmes octets ;
+    2. chaque nonce de la réserve ne sert qu'une fois (retiré et effacé avant la signature), puis on revient à
+       uECC_sign() quand la réserve est vide ;
+    3. après un redémarrage (nouvel état de la fonction aléatoire, graine de l'eeprom renouvelée), aucun nonce ne
+       réapparaît ;
+    4. deux appareils neufs (eeprom effacée, même compteur de démarrages) ne tirent pas les mêmes octets : l'état vient
+       des relevés du chien de garde (gigue simulée par hote.c), pas du compteur.
+    Le test échoue avec un code de retour non nul. À lancer avec 'make test-hote' (dossier 'programme').  */
+#include <stdio.h>
+
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+#define EQUIVALENCES 200
+#define DEMARRAGES 20
+
+//  Fonction aléatoire rejouable : on sauvegarde 'graine_test' avant un tirage pour le refaire à l'identique
+static uint32_t graine_test = 1;
+
+static int rng_test(uint8_t *destination, unsigned taille){
+    for(unsigned i=0; i<taille; i++){
+        graine_test ^= graine_test << 13;
+        graine_test ^= graine_test >> 17;
+        graine_test ^= graine_test << 5;
+        destination[i] = graine_test;
+    }
+    return 1;
+}
+
+//  Valeurs de r déjà rencontrées (un nonce réutilisé redonne le même r)
+static uint8_t r_vus[DEMARRAGES * TAILLE_RESERVE][uECC_BYTES];
+static int nombre_r_vus = 0;
+
+static int r_nouveau(const uint8_t *r){
+    for(int i=0; i<nombre_r_vus; i++){
+        if(!memcmp(r_vus[i], r, uECC_BYTES)){
+            return 0;
+        }
+    }
+    memcpy(r_vus[nombre_r_vus++], r, uECC_BYTES);
+    return 1;
+}
+
+int main(){
+    uint8_t private_key[TAILLE_CLE_PRIVE], public_key[TAILLE_CLE_PUBLIC], hash[TAILLE_DATA_HASH];
+    uint8_t signature[TAILLE_SIGNATURE], attendue[TAILLE_SIGNATURE];
+    uECC_Nonce nonce, vide;
+    int echecs = 0;
+
+    hote_eeprom_effacement();
+    config();
+    uECC_make_key(public_key, private_key);
+
+    //  1. Signature en deux temps = uECC_sign() avec les mêmes tirages
+    uECC_set_rng(rng_test);
+    for(int i=0; i<EQUIVALENCES; i++){
+        rng_test(hash, sizeof(hash));
+        uint32_t graine = graine_test;
+        if(!uECC_make_nonce(&nonce) || !uECC_sign_with_nonce(private_key, hash, &nonce, signature)){
+            printf("ECHEC : signature avec nonce impossible\n");
+            echecs++;
+            continue;
+        }
+        graine_test = graine;
+        uECC_sign(private_key, hash, attendue);
+        if(memcmp(signature, attendue, sizeof(signature))){
+            printf("ECHEC : la signature avec nonce diffère de uECC_sign()\n");
+            echecs++;
+        }
+    }
+    printf("Signature en deux temps identique à uECC_sign() : %d signatures\n", EQUIVALENCES);
+    uECC_set_rng(avr_rng);
+
+    //  2 et 3. Réserve remplie puis vidée à chaque démarrage, les r doivent tous être différents
+    memset(&vide, 0, sizeof(vide));
+    for(int d=0; d<DEMARRAGES; d++){
+        reserve_compteur = 0;       // Redémarrage : la SRAM est perdue, la graine change
+        initialisation_aleatoire();
+        while(reserve_compteur < TAILLE_RESERVE){
+            remplissage_reserve();
+        }
+        for(int i=0; i<TAILLE_RESERVE; i++){
+            uint8_t restants = reserve_compteur;
+            memcpy(&nonce, &reserve_nonces[restants - 1], sizeof(nonce));
+            rng_test(hash, sizeof(hash));
+            if(!signature_reserve(private_key, hash, signature)){
+                printf("ECHEC : signature impossible\n");
+                echecs++;
+            }
+            if(reserve_compteur != restants - 1 || memcmp(&reserve_nonces[restants - 1], &vide, sizeof(vide))){
+                printf("ECHEC : nonce non retiré de la réserve\n");
+                echecs++;
+            }
+            if(memcmp(signature, nonce.r, uECC_BYTES) || !r_nouveau(signature)){
+                printf("ECHEC : nonce réutilisé (démarrage %d)\n", d + 1);
+                echecs++;
+            }
+        }
+        //  Réserve vide : uECC_sign() prend le relais
+        if(!signature_reserve(private_key, hash, signature) || reserve_compteur != 0){
+            printf("ECHEC : signature avec la réserve vide\n");
+            echecs++;
+        }
+    }
+    printf("%d démarrages, %d nonces de la réserve tous différents\n", DEMARRAGES, nombre_r_vus);
+
+    //  4. Eeprom neuve deux fois de suite : premiers tirages différents, graine écrite dans l'eeprom
+    uint8_t tirages[2][32], graine[TAILLE_GRAINE], neuve[TAILLE_GRAINE];
+    memset(neuve, 0xFF, sizeof(neuve));
+    for(int a=0; a<2; a++){
+        hote_eeprom_effacement();
+        initialisation_aleatoire();
+        avr_rng(tirages[a], sizeof(tirages[a]));
+        eeprom_read_block(graine, graine_eeprom, TAILLE_GRAINE);
+        if(!memcmp(graine, neuve, TAILLE_GRAINE)){
+            printf("ECHEC : graine non écrite dans l'eeprom\n");
+            echecs++;
+        }
+    }
+    if(!memcmp(tirages[0], tirages[1], sizeof(tirages[0]))){
+        printf("ECHEC : deux eeproms neuves donnent les mêmes tirages\n");
+        echecs++;
+    }
+    printf("Eeprom neuve : tirages différents d'un appareil à l'autre\n");
+
+    if(echecs){
+        printf("ECHEC : %d erreur(s)\n", echecs);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*  Test hôte de RESET par changement d'époque (partie 5 de main.c), compilé avec le profil EFFACEMENT_CLES :
+    1. RESET programme le même nombre d'octets (une cellule de l'en-tête) avec 1 ou 16 entrées, et les entrées ne
+       reviennent pas au redémarrage ;
+    2. après un tour complet des époques, un enregistrement écrit 254 RESET plus tôt ne redevient pas valide ;
+    3. la boucle principale met à zéro les clés supprimées en tâche de fond, l'effacement reprend après un redémarrage,
+       et un nouvel enregistrement dans un emplacement en cours d'effacement n'est pas effacé ;
+    4. une eeprom écrite par une version précédente (trois anciennes dispositions, dont un magasin plein de 17
+       entrées) est reprise au premier démarrage : les entrées sont retrouvées avec leur clé, y compris après un
+       redémarrage, et un nouvel enregistrement suit la reprise.
+    Le test échoue avec un code de retour non nul. À lancer avec 'make test-hote' (dossier 'programme').  */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define EFFACEMENT_CLES 1
+#define main programme_main
+#include "../main.c"
+#undef main
+
+#include "hote.h"
+
+static int echecs = 0;
+
+static void verification(int condition, const char *message){
+    if(!condition){
+        printf("ECHEC : %s\n", message);
+        echecs++;
+    }
+}
+
+static void enregistrements(uint8_t nombre){
+    uint8_t app_id_hash[TAILLE_APP_ID_HASH], private_key[TAILLE_CLE_PRIVE];
+    for(uint8_t a=0; a<nombre; a++){
+        for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+            app_id_hash[i] = rand();
+        }
+        for(int i=0; i<TAILLE_CLE_PRIVE; i++){
+            private_key[i] = rand() | 1;    // Aucun octet nul : tous sont à effacer
+        }
+        verification(sauvegarde_entree_eeprom(app_id_hash, app_id_hash, private_key), "enregistrement");
+    }
+}
+
+//  Octets de la clé de l'emplacement 'e' non encore mis à zéro
+static int octets_restants(uint8_t e){
+    int restants = 0;
+    for(int i=0; i<TAILLE_CLE_PRIVE; i++){
+        restants += magasin_eeprom[e][ENR_CLE_PRIVE + i] != 0x00;
+    }
+    return restants;
+}
+
+/*  Ancienne disposition : 'nombre' entrées de 58 octets après le compteur (position 'compteur' depuis le début de
+    l'eeprom), index des empreintes à la position 'index' (SANS_INDEX : pas d'index). Entrée a : app_id_hash a + 1...,
+    credential_id et clé dérivés de a.  */
+static void ancien_magasin(uint8_t compteur, int8_t index, uint8_t nombre){
+    uint8_t entree[ANCIENNE_TAILLE_ENTREE];
+    hote_eeprom_effacement();
+    eeprom_write_byte((uint8_t *)entete_eeprom + compteur, nombre);
+    for(uint8_t a=0; a<nombre; a++){
+        for(int i=0; i<ANCIENNE_TAILLE_ENTREE - 1; i++){
+            entree[i] = a + 1 + i * 7;
+        }
+        entree[ANCIENNE_TAILLE_ENTREE - 1] = ANCIEN_OCCUPE;
+        eeprom_write_block(entree, ancienne_entree(compteur, a), ANCIENNE_TAILLE_ENTREE);
+        if(index != SANS_INDEX){
+            eeprom_write_byte((uint8_t *)entete_eeprom + index + a, empreinte_app_id(entree));
+        }
+    }
+}
+
+//  Nombre d'entrées de l'ancienne disposition retrouvées avec leur credential_id et leur clé
+static uint8_t entrees_retrouvees(uint8_t nombre){
+    uint8_t attendu[ANCIENNE_TAILLE_ENTREE - 1];
+    uint8_t credential_id[TAILLE_CREDENTIAL_ID], private_key[TAILLE_CLE_PRIVE];
+    uint8_t retrouvees = 0;
+    for(uint8_t a=0; a<nombre; a++){
+        for(int i=0; i<ANCIENNE_TAILLE_ENTREE - 1; i++){
+            attendu[i] = a + 1 + i * 7;
+        }
+        retrouvees += recherche_entree_eeprom(attendu, credential_id, private_key) &&
+                      memcmp(credential_id, attendu + TAILLE_APP_ID_HASH, TAILLE_CREDENTIAL_ID) == 0 &&
+                      memcmp(private_key, attendu + TAILLE_APP_ID_HASH + TAILLE_CREDENTIAL_ID, TAILLE_CLE_PRIVE) == 0;
+    }
+    return retrouvees;
+}
+
+//  RESET : octets programmés
+static uint32_t reset(){
+    uint32_t avant = eeprom_octets_programmes;
+    suppression_entrees_eeprom();
+    return eeprom_octets_programmes - avant;
+}
+
+int main(){
+    uint32_t octets_une, octets_pleine;
+
+    hote_eeprom_effacement();
+    config();
+
+    //  1. Coût constant, entrées perdues au redémarrage
+    enregistrements(1);
+    octets_une = reset();
+    enregistrements(MAX_ENTREES);
+    octets_pleine = reset();
+    printf("RESET : %u octets programmés avec 1 entrée, %u avec %d entrées\n", octets_une, octets_pleine, MAX_ENTREES);
+    verification(octets_une == octets_pleine && octets_pleine <= TAILLE_CELLULE, "RESET en temps constant");
+    chargement_magasin();
+    verification(nombre_entrees == 0, "entrées revenues après RESET et redémarrage");
+
+    //  2. Tour complet des époques : l'emplacement écrit à l'époque de départ ne doit pas revenir
+    hote_eeprom_effacement();
+    chargement_magasin();
+    enregistrements(1);
+    uint8_t depart = epoque_courante;
+    for(int i=0; i<EPOQUE_MAX - EPOQUE_MIN + 1; i++){
+        reset();
+    }
+    verification(epoque_courante == depart, "tour complet des époques");
+    chargement_magasin();
+    verification(nombre_entrees == 0, "enregistrement revenu après un tour complet des époques");
+
+    //  3. Effacement en tâche de fond, interrompu par un redémarrage
+    hote_eeprom_effacement();
+    chargement_magasin();
+    emplacement_suivant = 0;
+    enregistrements(4);
+    reset();
+    verification(emplacements_a_effacer == 0x000F, "clés à effacer après RESET");
+    for(int i=0; i<30; i++){
+        tour_boucle();      // 4 nonces pour la réserve, puis effacement de l'emplacement 0 (22 tours) et début du 1
+    }
+    verification(octets_restants(0) == 0 && octets_restants(1) > 0, "effacement progressif");
+
+    chargement_magasin();   // Redémarrage : effacement repris pour les emplacements 1 à 3
+    verification(emplacements_a_effacer == 0x000E, "effacement repris au redémarrage");
+    enregistrements(1);     // Emplacement 4 (suite du journal)
+    emplacement_suivant = 2;
+    enregistrements(1);     // Emplacement 2, en cours d'effacement : sa nouvelle clé doit rester
+    while(emplacements_a_effacer){
+        tour_boucle();
+    }
+    verification(octets_restants(1) == 0 && octets_restants(3) == 0, "clés supprimées effacées");
+    verification(octets_restants(2) == TAILLE_CLE_PRIVE && octets_restants(4) == TAILLE_CLE_PRIVE,
+                 "clé d'une entrée en cours effacée");
+    chargement_magasin();
+    verification(nombre_entrees == 2 && emplacements_a_effacer == 0, "état après effacement et redémarrage");
+
+    //  4. Reprise des anciennes dispositions (démarrages, index puis compteur ; index puis compteur ; compteur seul)
+    const uint8_t compteurs[3] = {ANCIEN_COMPTEUR_INDEX_DEMARRAGES, ANCIEN_COMPTEUR_INDEX, ANCIEN_COMPTEUR};
+    const int8_t index[3] = {ANCIEN_INDEX_DEMARRAGES, ANCIEN_INDEX, SANS_INDEX};
+    for(int d=0; d<3; d++){
+        for(uint8_t nombre=1; nombre<=ANCIEN_MAX_ENTREES; nombre+=8){
+            uint8_t repris = (nombre < MAX_ENTREES) ? nombre : MAX_ENTREES;
+            ancien_magasin(compteurs[d], index[d], nombre);
+            chargement_magasin();
+            verification(nombre_entrees == repris && entrees_retrouvees(repris) == repris, "ancien magasin repris");
+            chargement_magasin();
+            verification(nombre_entrees == repris && entrees_retrouvees(repris) == repris, "reprise après redémarrage");
+            if(repris < MAX_ENTREES){
+                enregistrements(1);
+                verification(emplacement_suivant == repris + 1 && entrees_retrouvees(repris) == repris,
+                             "enregistrement après la reprise");
+            }
+        }
+    }
+    printf("Reprise des anciennes dispositions : 1, 9 et 17 entrées (16 reprises)\n");
+    hote_eeprom_effacement();
+    chargement_magasin();
+    verification(nombre_entrees == 0, "eeprom neuve prise pour une ancienne disposition");
+
+    if(echecs){
+        printf("ECHEC : %d erreur(s)\n", echecs);
+        return 1;
+    }
+    printf("OK\n");
+    return 0;
+}
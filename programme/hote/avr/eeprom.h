@@ -0,0 +1,21 @@
+/*  Remplacement de <avr/eeprom.h> pour la compilation hôte (x86_64).
+    Les variables EEMEM sont regroupées dans la section 'eeprom_hote' : c'est l'image de l'eeprom du microcontrôleur.
+    Chaque accès est compté (voir hote.h) afin de pouvoir mesurer le coût des opérations sur la mémoire.  */
+#ifndef HOTE_AVR_EEPROM_H
+#define HOTE_AVR_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define EEMEM __attribute__((section("eeprom_hote")))
+
+uint8_t eeprom_read_byte(const uint8_t *adresse);
+void eeprom_write_byte(uint8_t *adresse, uint8_t valeur);
+void eeprom_update_byte(uint8_t *adresse, uint8_t valeur);
+uint32_t eeprom_read_dword(const uint32_t *adresse);
+void eeprom_write_dword(uint32_t *adresse, uint32_t valeur);
+void eeprom_read_block(void *destination, const void *source, size_t taille);
+void eeprom_write_block(const void *source, void *destination, size_t taille);
+void eeprom_update_block(const void *source, void *destination, size_t taille);
+
+#endif
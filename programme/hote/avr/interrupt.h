@@ -0,0 +1,16 @@
+/*  Remplacement de <avr/interrupt.h> pour la compilation hôte (x86_64).
+    Une routine d'interruption devient une fonction ordinaire, appelée par hote.c quand l'événement simulé se
+    produit et que les interruptions sont autorisées.  */
+#ifndef HOTE_AVR_INTERRUPT_H
+#define HOTE_AVR_INTERRUPT_H
+
+#include <stdint.h>
+
+#define ISR(vecteur) void vecteur(void)
+
+extern volatile uint8_t hote_interruptions;     // Bit I du registre SREG
+
+#define sei() (hote_interruptions = 1)
+#define cli() (hote_interruptions = 0)
+
+#endif
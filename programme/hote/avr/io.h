@@ -0,0 +1,66 @@
+/*  Remplacement de <avr/io.h> pour la compilation hôte (x86_64).
+    Les registres utilisés par le programme sont de simples variables globales (définies dans hote.c),
+    ce qui permet de compiler main.c tel quel et de l'exécuter sans carte.  */
+#ifndef HOTE_AVR_IO_H
+#define HOTE_AVR_IO_H
+
+#include <stdint.h>
+
+//  Port D (LED et bouton)
+extern volatile uint8_t DDRD, PORTD, PIND;
+#define PD2 2
+#define PD4 4
+
+/*  USART0. Une lecture de UCSR0A (attente active du programme) fait avancer l'horloge virtuelle et traite les
+    événements de la liaison. UDR0 fait 16 bits : hote.c y place une valeur hors de la plage d'un octet avant
+    d'appeler l'interruption d'émission, ce qui lui permet de savoir si un octet a été écrit.  */
+extern volatile uint8_t UBRR0H, UBRR0L, UCSR0B, UCSR0C;
+extern volatile uint16_t UDR0;
+volatile uint8_t *hote_ucsr0a();
+#define UCSR0A (*hote_ucsr0a())
+#define RXC0 7
+#define TXC0 6
+#define UDRE0 5
+#define U2X0 1
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0 4
+#define TXEN0 3
+#define UCSZ01 2
+#define UCSZ00 1
+
+/*  Timer2, en mode CTC uniquement : quand OCIE2A est actif, TIMER2_COMPA_vect est appelée toutes les
+    (OCR2A + 1) * prédiviseur périodes d'horloge (prédiviseur choisi par CS22:0 dans TCCR2B).  */
+extern volatile uint8_t TCCR2A, TCCR2B, OCR2A, TIMSK2, TCNT2;
+#define WGM21 1
+#define CS22 2
+#define CS21 1
+#define CS20 0
+#define OCIE2A 1
+
+/*  Timer1, en compteur libre uniquement : TCNT1 est calculé à partir de l'horloge virtuelle (prédiviseur choisi par
+    CS12:0 dans TCCR1B, compteur arrêté si CS12:0 = 0).  */
+extern volatile uint8_t TCCR1A, TCCR1B;
+volatile uint16_t *hote_tcnt1();
+#define TCNT1 (*hote_tcnt1())
+#define CS12 2
+#define CS11 1
+#define CS10 0
+
+/*  Chien de garde, en mode interruption seule (WDIE) : WDT_vect est appelée toutes les (2048 << WDP3:0) périodes de
+    l'oscillateur RC de 128 kHz. La durée de chaque période varie au hasard de +-1 % (gigue de l'oscillateur RC, tirée
+    d'une graine de getentropy()). Le mode remise à zéro (WDE sans WDIE) n'est pas simulé.  */
+extern volatile uint8_t WDTCSR;
+#define WDIE 6
+#define WDP3 5
+#define WDCE 4
+#define WDE 3
+#define WDP2 2
+#define WDP1 1
+#define WDP0 0
+
+//  Registre d'usage général (repères de phase du banc d'essai simavr, sans effet ici)
+extern volatile uint8_t GPIOR0;
+
+#endif
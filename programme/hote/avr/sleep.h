@@ -0,0 +1,16 @@
+/*  Remplacement de <avr/sleep.h> pour la compilation hôte (x86_64) : la veille fait avancer l'horloge virtuelle
+    jusqu'au prochain événement simulé (octet reçu, fin d'émission, ...) et exécute son interruption.  */
+#ifndef HOTE_AVR_SLEEP_H
+#define HOTE_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE 0
+
+void hote_veille();
+
+#define set_sleep_mode(mode) ((void)(mode))
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu() hote_veille()
+#define sleep_mode() hote_veille()
+
+#endif
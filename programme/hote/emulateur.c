@@ -0,0 +1,142 @@
+/*  Émulateur de l'Authenticator sur PC : le programme de la carte (main.c, bibliothèque libyubino.a) tourne sur le
+    matériel simulé du dossier 'hote', en temps réel. La liaison série est un pseudo-terminal (ou l'entrée et la sortie
+    standard), l'eeprom est un fichier et le bouton est piloté par un script. Le client Python et ses tests
+    (yubino-client) s'y connectent comme à la carte :
+        make emulateur
+        ./hote/yubino_emulateur -l /tmp/yubino &
+        yubino -d /tmp/yubino
+
+    Options :
+        -e fichier  image de l'eeprom (créée si elle n'existe pas), par défaut 'eeprom.bin'
+        -l lien     lien symbolique vers le pseudo-terminal (son chemin est aussi affiché au démarrage)
+        -s          liaison série sur l'entrée et la sortie standard au lieu d'un pseudo-terminal
+        -b script   réponse de l'utilisateur à chaque demande de confirmation, une lettre par demande : 'o' (appui)
+                    ou 'n' (pas d'appui, la demande expire au bout de 10 s). La dernière lettre se répète.
+                    Par défaut 'o'
+        -a ms       délai entre le début de la demande de confirmation et l'appui, par défaut 100 ms  */
+#define _GNU_SOURCE     // posix_openpt(), cfmakeraw()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "hote.h"
+
+//  Programme de la carte (main.c compilé avec main renommé en programme_main)
+int programme_main();
+extern volatile uint8_t clignotement;       // LED clignotante : demande de confirmation en cours
+extern volatile uint8_t bouton_etat, bouton_appuie;
+extern volatile uint16_t millisecondes;
+extern uint16_t confirmation_debut;
+
+static const char *script = "o";
+static uint16_t delai_appui_ms = 100;
+
+/*  Bouton scripté, appelé après chaque interruption du Timer2 : au début de chaque demande de confirmation, on lit la
+    lettre suivante du script ; pour 'o', le bouton est appuyé au bout du délai et relâché dès que le programme a validé
+    l'appui (filtrage terminé).
+    La demande suivie se termine quand la LED s'arrête de clignoter, quand l'appui validé a été consommé par le
+    programme ou quand une nouvelle demande a commencé : à grande vitesse, le client envoie la requête suivante dans la
+    même milliseconde que la réponse, et la LED peut ne jamais être vue éteinte entre deux demandes.  */
+void hote_tic(){
+    static uint8_t en_cours = 0;
+    static uint8_t appui;           // 0 : pas d'appui, 1 : appui à faire, 2 : appui validé par le programme
+    static uint16_t debut;
+
+    if(en_cours && (!clignotement || confirmation_debut != debut || (appui == 2 && !bouton_appuie))){
+        en_cours = 0;
+        hote_bouton(0);
+    }
+    if(clignotement && !en_cours){
+        en_cours = 1;
+        debut = confirmation_debut;
+        appui = (*script == 'o');
+        if(script[1]){
+            script++;
+        }
+    }
+    if(en_cours && appui == 1){
+        if(bouton_appuie){
+            appui = 2;
+            hote_bouton(0);
+        }
+        else if(bouton_etat && (uint16_t)(millisecondes - debut) >= delai_appui_ms){
+            hote_bouton(1);     // Le relâchement précédent doit avoir été validé pour que l'appui soit vu
+        }
+    }
+}
+
+//  Pseudo-terminal en mode brut (octets transmis tels quels). Renvoie le descripteur du côté maître
+static int pseudo_terminal(const char *lien){
+    int maitre = posix_openpt(O_RDWR | O_NOCTTY);
+    if(maitre < 0 || grantpt(maitre) < 0 || unlockpt(maitre) < 0){
+        perror("emulateur : pseudo-terminal");
+        exit(1);
+    }
+    const char *chemin = ptsname(maitre);
+
+    /*  Le côté esclave reste ouvert ici : sans lui, le maître signalerait une fermeture chaque fois que le client se
+        déconnecte.  */
+    int esclave = open(chemin, O_RDWR | O_NOCTTY);
+    struct termios modes;
+    if(esclave < 0 || tcgetattr(esclave, &modes) < 0){
+        perror("emulateur : pseudo-terminal");
+        exit(1);
+    }
+    cfmakeraw(&modes);
+    tcsetattr(esclave, TCSANOW, &modes);
+
+    if(lien){
+        unlink(lien);
+        if(symlink(chemin, lien) < 0){
+            perror("emulateur : lien vers le pseudo-terminal");
+            exit(1);
+        }
+    }
+    printf("Authenticator émulé sur %s\n", chemin);
+    fflush(stdout);
+    return maitre;
+}
+
+int main(int argc, char **argv){
+    const char *eeprom = "eeprom.bin";
+    const char *lien = NULL;
+    int standard = 0;
+    int option;
+
+    while((option = getopt(argc, argv, "e:l:sb:a:")) != -1){
+        if(option == 'e'){
+            eeprom = optarg;
+        }
+        else if(option == 'l'){
+            lien = optarg;
+        }
+        else if(option == 's'){
+            standard = 1;
+        }
+        else if(option == 'b' && strspn(optarg, "on") == strlen(optarg) && *optarg){
+            script = optarg;
+        }
+        else if(option == 'a'){
+            delai_appui_ms = strtoul(optarg, NULL, 10);
+        }
+        else{
+            fprintf(stderr, "usage : %s [-e eeprom.bin] [-l lien] [-s] [-b script (o/n...)] [-a délai_ms]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(!hote_eeprom_fichier(eeprom)){
+        perror("emulateur : eeprom");
+        return 1;
+    }
+    if(standard){
+        hote_temps_reel(STDIN_FILENO, STDOUT_FILENO);
+    }
+    else{
+        int maitre = pseudo_terminal(lien);
+        hote_temps_reel(maitre, maitre);
+    }
+    return programme_main();
+}
@@ -0,0 +1,510 @@
+/*  Matériel simulé pour la compilation hôte (x86_64) du programme : registres, eeprom, liaison série et délais.
+    Le temps est virtuel : il avance avec les délais, les attentes actives sur UCSR0A, les écritures dans l'eeprom et les
+    mises en veille.
+    En mode temps réel (émulateur, voir hote_temps_reel()), l'horloge virtuelle suit l'horloge réelle et la liaison
+    série est un vrai descripteur de fichier.  */
+#define _GNU_SOURCE     // ppoll()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/random.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include "hote.h"
+
+//  Routines d'interruption du programme (définies dans main.c)
+extern void USART_RX_vect(void) __attribute__((weak));
+extern void USART_UDRE_vect(void) __attribute__((weak));
+extern void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern void WDT_vect(void) __attribute__((weak));
+
+//  Fonction appelée après chaque interruption du Timer2 (définie par l'émulateur pour le bouton scripté)
+extern void hote_tic(void) __attribute__((weak));
+
+//  Registres
+volatile uint8_t DDRD, PORTD, PIND = 0xFF;
+volatile uint8_t UBRR0H, UBRR0L, UCSR0B, UCSR0C;
+volatile uint16_t UDR0;
+volatile uint8_t TCCR2A, TCCR2B, OCR2A, TIMSK2, TCNT2;
+volatile uint8_t TCCR1A, TCCR1B;
+volatile uint8_t WDTCSR;
+volatile uint8_t GPIOR0;
+static volatile uint8_t ucsr0a = (1 << UDRE0);
+volatile uint8_t hote_interruptions = 0;
+
+//  Bornes de l'image de l'eeprom (section regroupant les variables EEMEM, créées par l'éditeur de liens)
+extern uint8_t __start_eeprom_hote[];
+extern uint8_t __stop_eeprom_hote[];
+
+uint32_t hote_eeprom_lectures = 0;
+uint32_t hote_eeprom_ecritures = 0;
+uint64_t hote_horloge_ns = 0;
+static int eeprom_fichier = -1;     // Image de l'eeprom sur disque (émulateur), -1 sinon
+
+/*  Durée de programmation d'un octet de l'eeprom (effacement et écriture, 3,3 ms dans la documentation de l'atmega328p,
+    3,4 ms avec l'horloge de l'eeprom) : eeprom_write_byte() de avr-libc attend la fin de l'écriture précédente.  */
+#define DUREE_ECRITURE_EEPROM_NS 3400000ull
+
+static void avance(uint64_t instant);
+
+//  Usure de l'eeprom : nombre d'écritures de chaque octet de l'image depuis la dernière remise à zéro
+#define TAILLE_EEPROM_MAX 4096
+static uint32_t eeprom_usure[TAILLE_EEPROM_MAX];
+
+void hote_compteurs_raz(){
+    hote_eeprom_lectures = 0;
+    hote_eeprom_ecritures = 0;
+}
+
+uint16_t hote_eeprom_taille(){
+    return __stop_eeprom_hote - __start_eeprom_hote;
+}
+
+uint16_t hote_eeprom_position(const void *adresse){
+    return (const uint8_t *)adresse - __start_eeprom_hote;
+}
+
+uint32_t hote_eeprom_usure(uint16_t position){
+    return eeprom_usure[position];
+}
+
+void hote_eeprom_usure_raz(){
+    memset(eeprom_usure, 0, sizeof(eeprom_usure));
+}
+
+void hote_eeprom_effacement(){
+    memset(__start_eeprom_hote, 0xFF, __stop_eeprom_hote - __start_eeprom_hote);
+}
+
+/*  Eeprom dans un fichier : chargée depuis 'chemin' s'il existe, sinon créée à partir des valeurs initiales des
+    variables EEMEM (comme après le chargement de main.eep dans la carte). Chaque écriture est ensuite recopiée dans
+    le fichier. Renvoie 0 en cas d'erreur.  */
+int hote_eeprom_fichier(const char *chemin){
+    size_t taille = __stop_eeprom_hote - __start_eeprom_hote;
+    struct stat etat;
+    eeprom_fichier = open(chemin, O_RDWR | O_CREAT, 0644);
+    if(eeprom_fichier < 0 || fstat(eeprom_fichier, &etat) < 0){
+        return 0;
+    }
+    if((size_t)etat.st_size == taille){
+        return read(eeprom_fichier, __start_eeprom_hote, taille) == (ssize_t)taille;
+    }
+    return ftruncate(eeprom_fichier, 0) == 0 && pwrite(eeprom_fichier, __start_eeprom_hote, taille, 0) == (ssize_t)taille;
+}
+
+static void eeprom_sauvegarde(const void *adresse, size_t taille){
+    if(eeprom_fichier >= 0){
+        if(pwrite(eeprom_fichier, adresse, taille, (const uint8_t *)adresse - __start_eeprom_hote) != (ssize_t)taille){
+            perror("hote : écriture de l'eeprom");
+        }
+    }
+}
+
+//  Eeprom
+uint8_t eeprom_read_byte(const uint8_t *adresse){
+    hote_eeprom_lectures++;
+    return *adresse;
+}
+
+void eeprom_write_byte(uint8_t *adresse, uint8_t valeur){
+    hote_eeprom_ecritures++;
+    eeprom_usure[hote_eeprom_position(adresse)]++;
+    *adresse = valeur;
+    eeprom_sauvegarde(adresse, 1);
+    avance(hote_horloge_ns + DUREE_ECRITURE_EEPROM_NS);
+}
+
+void eeprom_update_byte(uint8_t *adresse, uint8_t valeur){
+    hote_eeprom_lectures++;
+    if(*adresse != valeur){
+        eeprom_write_byte(adresse, valeur);
+    }
+}
+
+uint32_t eeprom_read_dword(const uint32_t *adresse){
+    uint32_t valeur;
+    eeprom_read_block(&valeur, adresse, sizeof(valeur));
+    return valeur;
+}
+
+void eeprom_write_dword(uint32_t *adresse, uint32_t valeur){
+    eeprom_write_block(&valeur, adresse, sizeof(valeur));
+}
+
+void eeprom_read_block(void *destination, const void *source, size_t taille){
+    hote_eeprom_lectures += taille;
+    memcpy(destination, source, taille);
+}
+
+void eeprom_write_block(const void *source, void *destination, size_t taille){
+    hote_eeprom_ecritures += taille;
+    for(size_t i=0; i<taille; i++){
+        eeprom_usure[hote_eeprom_position((const uint8_t *)destination + i)]++;
+    }
+    memcpy(destination, source, taille);
+    eeprom_sauvegarde(destination, taille);
+    avance(hote_horloge_ns + taille * DUREE_ECRITURE_EEPROM_NS);
+}
+
+void eeprom_update_block(const void *source, void *destination, size_t taille){
+    for(size_t i=0; i<taille; i++){
+        eeprom_update_byte((uint8_t *)destination + i, ((const uint8_t *)source)[i]);
+    }
+}
+
+/*  Liaison série : les octets envoyés par l'hôte arrivent un par un, au rythme du baudrate configuré dans
+    UBRR0/U2X0 (10 bits par octet), et déclenchent USART_RX_vect. Tant que UDRIE0 est actif, USART_UDRE_vect est
+    appelée chaque fois que le registre d'émission est libre ; l'octet qu'elle écrit dans UDR0 part vers l'hôte.  */
+#define UART_TAILLE 4096
+#define UDR0_VIDE 0x100
+#define AUCUN_EVENEMENT UINT64_MAX
+
+static uint8_t uart_entree[UART_TAILLE];    // Octets envoyés par l'hôte, pas encore reçus par le programme
+static uint16_t uart_entree_debut = 0, uart_entree_fin = 0;
+static uint64_t uart_entree_instant;        // Instant d'arrivée du prochain octet
+static uint8_t uart_sortie[UART_TAILLE];    // Octets émis par le programme, pas encore récupérés par l'hôte
+static uint16_t uart_sortie_fin = 0;
+static uint64_t uart_emission_libre = 0;    // Instant où le dernier octet émis sera entièrement sorti
+static uint8_t uart_emission_en_cours = 0;
+
+//  Durée d'un octet (1 bit de start, 8 bits de données, 1 bit de stop) en ns
+static uint64_t duree_octet(){
+    uint16_t ubrr = ((uint16_t)UBRR0H << 8) | UBRR0L;
+    uint32_t diviseur = (ucsr0a & (1 << U2X0)) ? 8 : 16;
+    return 10ull * 1000000000ull * diviseur * (ubrr + 1) / F_CPU;
+}
+
+//  Timer2 : période de l'interruption de comparaison en ns (0 si elle est désactivée)
+static const uint16_t prediviseurs_timer2[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+static uint64_t timer2_instant = 0;     // Instant de la prochaine interruption (0 : timer pas encore armé)
+
+static uint64_t periode_timer2(){
+    uint16_t prediviseur = prediviseurs_timer2[TCCR2B & 0x07];
+    if(!(TIMSK2 & (1 << OCIE2A)) || !prediviseur){
+        return 0;
+    }
+    return 1000000000ull * prediviseur * (OCR2A + 1) / F_CPU;
+}
+
+//  Timer1 : valeur du compteur libre, lue à l'instant présent de l'horloge virtuelle
+static const uint16_t prediviseurs_timer1[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+static uint16_t tcnt1;
+
+volatile uint16_t *hote_tcnt1(){
+    uint16_t prediviseur = prediviseurs_timer1[TCCR1B & 0x07];
+    if(prediviseur){
+        tcnt1 = hote_horloge_ns * (F_CPU / 1000000) / 1000 / prediviseur;
+    }
+    return &tcnt1;
+}
+
+/*  Chien de garde : période nominale de l'interruption en ns (0 si elle est désactivée), et gigue de l'oscillateur RC
+    (xorshift32 dont la graine vient de getentropy() : deux exécutions ne voient pas la même suite de périodes)  */
+static uint64_t wdt_instant = 0;        // Instant de la prochaine interruption (0 : chien de garde pas encore armé)
+static uint32_t wdt_gigue = 0;
+
+static uint64_t periode_wdt(){
+    if(!(WDTCSR & (1 << WDIE))){
+        return 0;
+    }
+    uint8_t wdp = (WDTCSR & 0x07) | ((WDTCSR >> WDP3) & 1) << 3;
+    return (2048ull * 1000000000ull / 128000) << (wdp > 9 ? 9 : wdp);
+}
+
+static uint64_t periode_wdt_gigue(){
+    if(!wdt_gigue && (getentropy(&wdt_gigue, sizeof(wdt_gigue)) || !wdt_gigue)){
+        wdt_gigue = 1;
+    }
+    wdt_gigue ^= wdt_gigue << 13;
+    wdt_gigue ^= wdt_gigue >> 17;
+    wdt_gigue ^= wdt_gigue << 5;
+    uint64_t periode = periode_wdt();
+    return periode - periode / 100 + periode * (wdt_gigue % 2001) / 100000;  // +-1 %
+}
+
+//  Bouton : changement d'état programmé par hote_bouton_programme()
+static uint64_t bouton_instant = UINT64_MAX;
+static uint8_t bouton_etat_programme;
+
+//  Appel d'une routine d'interruption (les interruptions sont coupées pendant son exécution, comme sur l'AVR)
+static void interruption(void (*routine)(void)){
+    hote_interruptions = 0;
+    routine();
+    hote_interruptions = 1;
+}
+
+//  Instant du prochain événement qui réveillerait le programme
+static uint64_t prochain_evenement(){
+    uint64_t instant = AUCUN_EVENEMENT;
+    if(uart_entree_debut != uart_entree_fin && (UCSR0B & (1 << RXCIE0))){
+        instant = uart_entree_instant;
+    }
+    if((UCSR0B & (1 << UDRIE0)) && uart_emission_libre < instant){
+        instant = uart_emission_libre;
+    }
+    uint64_t periode = periode_timer2();
+    if(!periode){
+        timer2_instant = 0;
+    }
+    else{
+        if(!timer2_instant){
+            timer2_instant = hote_horloge_ns + periode;
+        }
+        if(timer2_instant < instant){
+            instant = timer2_instant;
+        }
+    }
+    if(!periode_wdt()){
+        wdt_instant = 0;
+    }
+    else{
+        if(!wdt_instant){
+            wdt_instant = hote_horloge_ns + periode_wdt_gigue();
+        }
+        if(wdt_instant < instant){
+            instant = wdt_instant;
+        }
+    }
+    if(bouton_instant < instant){
+        instant = bouton_instant;
+    }
+    return instant;
+}
+
+//  Traitement des événements arrivés à échéance. Renvoie le nombre d'interruptions exécutées (et de changements du bouton)
+static uint8_t evenements(){
+    uint8_t nombre = 0;
+    if(bouton_instant <= hote_horloge_ns){     // Une broche change même si les interruptions sont coupées
+        hote_bouton(bouton_etat_programme);
+        bouton_instant = UINT64_MAX;
+        nombre++;                               // (réveil sans interruption : le programme teste à nouveau)
+    }
+    if(!hote_interruptions){
+        return nombre;
+    }
+    while(1){
+        if(uart_entree_debut != uart_entree_fin && (UCSR0B & (1 << RXCIE0))
+           && uart_entree_instant <= hote_horloge_ns){
+            UDR0 = uart_entree[uart_entree_debut++];
+            uart_entree_instant += duree_octet();
+            if(USART_RX_vect){
+                interruption(USART_RX_vect);
+            }
+            nombre++;
+        }
+        else if((UCSR0B & (1 << UDRIE0)) && uart_emission_libre <= hote_horloge_ns){
+            UDR0 = UDR0_VIDE;
+            if(USART_UDRE_vect){
+                interruption(USART_UDRE_vect);
+            }
+            if(!(UDR0 & UDR0_VIDE)){
+                if(uart_sortie_fin < UART_TAILLE){
+                    uart_sortie[uart_sortie_fin++] = (uint8_t)UDR0;
+                }
+                uart_emission_libre = hote_horloge_ns + duree_octet();
+                uart_emission_en_cours = 1;
+                ucsr0a &= ~(1 << TXC0);
+            }
+            nombre++;
+        }
+        else if(periode_timer2() && timer2_instant && timer2_instant <= hote_horloge_ns){
+            timer2_instant += periode_timer2();
+            if(TIMER2_COMPA_vect){
+                interruption(TIMER2_COMPA_vect);
+            }
+            if(hote_tic){
+                hote_tic();
+            }
+            nombre++;
+        }
+        else if(periode_wdt() && wdt_instant && wdt_instant <= hote_horloge_ns){
+            wdt_instant += periode_wdt_gigue();
+            if(WDT_vect){
+                interruption(WDT_vect);
+            }
+            nombre++;
+        }
+        else{
+            break;
+        }
+    }
+    if(uart_entree_debut == uart_entree_fin){
+        uart_entree_debut = uart_entree_fin = 0;
+    }
+    if(uart_emission_en_cours && uart_emission_libre <= hote_horloge_ns && !(UCSR0B & (1 << UDRIE0))){
+        uart_emission_en_cours = 0;
+        ucsr0a |= (1 << TXC0);      // Transmission terminée
+    }
+    return nombre;
+}
+
+/*  Mode temps réel : liaison série sur de vrais descripteurs, horloge virtuelle jamais en retard sur l'horloge réelle
+    (un calcul ne prend pas de temps virtuel : après un calcul, l'horloge virtuelle rattrape l'horloge réelle et les
+    interruptions du Timer2 manquées sont exécutées d'un coup).  */
+static int liaison_entree = -1, liaison_sortie = -1;
+static uint64_t origine_ns;
+
+static uint64_t horloge_reelle(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec - origine_ns;
+}
+
+void hote_temps_reel(int entree, int sortie){
+    liaison_entree = entree;
+    liaison_sortie = sortie;
+    origine_ns = 0;
+    origine_ns = horloge_reelle() - hote_horloge_ns;
+}
+
+static void synchronisation(){
+    uint64_t maintenant = horloge_reelle();
+    if(maintenant > hote_horloge_ns){
+        hote_horloge_ns = maintenant;
+    }
+}
+
+//  Envoi sur la liaison des octets émis par le programme
+static void sortie_reelle(){
+    uint16_t envoyes = 0;
+    while(envoyes < uart_sortie_fin){
+        ssize_t n = write(liaison_sortie, uart_sortie + envoyes, uart_sortie_fin - envoyes);
+        if(n <= 0){
+            perror("hote : écriture sur la liaison");
+            exit(2);
+        }
+        envoyes += n;
+    }
+    uart_sortie_fin = 0;
+}
+
+/*  Attente réelle jusqu'à l'instant virtuel 'instant' (indéfiniment pour AUCUN_EVENEMENT), interrompue par l'arrivée
+    d'octets sur la liaison : ils sont transmis au programme comme s'ils venaient d'être envoyés par l'hôte.
+    Renvoie 1 si des octets sont arrivés.  */
+static uint8_t attente_reelle(uint64_t instant){
+    uint8_t tampon[256];
+    sortie_reelle();
+    while(1){
+        struct pollfd attente = {liaison_entree, POLLIN, 0};
+        struct timespec delai, *pdelai = NULL;
+        uint64_t maintenant = horloge_reelle();
+        if(instant != AUCUN_EVENEMENT){
+            uint64_t reste = instant > maintenant ? instant - maintenant : 0;
+            delai.tv_sec = reste / 1000000000ull;
+            delai.tv_nsec = reste % 1000000000ull;
+            pdelai = &delai;
+        }
+        int n = ppoll(&attente, 1, pdelai, NULL);
+        if(n > 0 && (attente.revents & POLLIN)){
+            ssize_t lus = read(liaison_entree, tampon, sizeof(tampon));
+            if(lus <= 0){
+                exit(0);    // Fin de l'entrée standard
+            }
+            synchronisation();
+            hote_uart_envoi(tampon, lus);
+            return 1;
+        }
+        if(n > 0){
+            exit(0);        // Liaison fermée
+        }
+        if(instant != AUCUN_EVENEMENT && horloge_reelle() >= instant){
+            return 0;
+        }
+    }
+}
+
+//  Avance de l'horloge virtuelle jusqu'à 'instant', en traitant les événements au fur et à mesure
+static void avance(uint64_t instant){
+    uint64_t suivant;
+    if(liaison_entree >= 0){
+        while(attente_reelle(instant));
+        synchronisation();
+    }
+    while(hote_interruptions && (suivant = prochain_evenement()) <= instant){
+        if(suivant > hote_horloge_ns){
+            hote_horloge_ns = suivant;
+        }
+        if(!evenements()){
+            break;
+        }
+    }
+    if(instant > hote_horloge_ns){
+        hote_horloge_ns = instant;
+    }
+    evenements();
+}
+
+volatile uint8_t *hote_ucsr0a(){
+    avance(hote_horloge_ns + 1000);     // Une lecture du registre dans une boucle d'attente : 1 µs
+    return &ucsr0a;
+}
+
+void hote_veille(){
+    if(!hote_interruptions){
+        fprintf(stderr, "hote : mise en veille avec les interruptions désactivées\n");
+        exit(2);
+    }
+    while(!evenements()){
+        uint64_t suivant = prochain_evenement();
+        if(liaison_entree >= 0){
+            attente_reelle(suivant);
+            synchronisation();
+            continue;
+        }
+        if(suivant == AUCUN_EVENEMENT){
+            fprintf(stderr, "hote : mise en veille sans aucun événement à venir (interblocage)\n");
+            exit(2);
+        }
+        if(suivant > hote_horloge_ns){
+            hote_horloge_ns = suivant;
+        }
+    }
+}
+
+void hote_uart_envoi(const uint8_t *donnees, uint16_t taille){
+    if(uart_entree_debut == uart_entree_fin){
+        uart_entree_instant = hote_horloge_ns + duree_octet();
+    }
+    for(uint16_t i=0; i<taille && uart_entree_fin < UART_TAILLE; i++){
+        uart_entree[uart_entree_fin++] = donnees[i];
+    }
+}
+
+uint16_t hote_uart_reception(uint8_t *donnees, uint16_t taille_max){
+    uint16_t taille = uart_sortie_fin < taille_max ? uart_sortie_fin : taille_max;
+    memcpy(donnees, uart_sortie, taille);
+    memmove(uart_sortie, uart_sortie + taille, uart_sortie_fin - taille);
+    uart_sortie_fin -= taille;
+    return taille;
+}
+
+//  Bouton (PD2, actif à l'état bas)
+void hote_bouton(uint8_t appuye){
+    if(appuye){
+        PIND &= ~(1 << PD2);
+    }
+    else{
+        PIND |= (1 << PD2);
+    }
+}
+
+void hote_bouton_programme(uint64_t instant, uint8_t appuye){
+    bouton_instant = instant;
+    bouton_etat_programme = appuye;
+}
+
+//  Délais
+void _delay_ms(double ms){
+    avance(hote_horloge_ns + (uint64_t)(ms * 1000000));
+}
+
+void _delay_us(double us){
+    avance(hote_horloge_ns + (uint64_t)(us * 1000));
+}
@@ -0,0 +1,36 @@
+/*  Compilation hôte (x86_64) du programme : interface des bancs d'essai avec le matériel simulé.  */
+#ifndef HOTE_H
+#define HOTE_H
+
+#include <stdint.h>
+
+//  Compteurs d'accès à l'eeprom (octets lus et écrits depuis la dernière remise à zéro)
+extern uint32_t hote_eeprom_lectures;
+extern uint32_t hote_eeprom_ecritures;
+
+//  Horloge virtuelle en nanosecondes (avancée par les délais, les attentes actives et les mises en veille)
+extern uint64_t hote_horloge_ns;
+
+//  Liaison série : octets envoyés au programme et octets émis par celui-ci
+void hote_uart_envoi(const uint8_t *donnees, uint16_t taille);
+uint16_t hote_uart_reception(uint8_t *donnees, uint16_t taille_max);
+
+void hote_bouton(uint8_t appuye);   // Bouton appuyé (1) ou relâché (0)
+void hote_bouton_programme(uint64_t instant, uint8_t appuye);   // Même chose à l'instant 'instant' (horloge virtuelle)
+
+void hote_compteurs_raz();      // Remise à zéro des compteurs d'accès à l'eeprom
+void hote_eeprom_effacement();  // Remet toute l'image de l'eeprom à 0xFF (comme une puce neuve)
+
+//  Usure de l'eeprom : taille de l'image, position d'une variable EEMEM dans l'image, nombre d'écritures de l'octet
+//  'position' depuis la dernière remise à zéro (hote_eeprom_usure_raz())
+uint16_t hote_eeprom_taille();
+uint16_t hote_eeprom_position(const void *adresse);
+uint32_t hote_eeprom_usure(uint16_t position);
+void hote_eeprom_usure_raz();
+
+//  Émulateur : eeprom dans un fichier (renvoie 0 en cas d'erreur), liaison série sur de vrais descripteurs et horloge
+//  virtuelle calée sur l'horloge réelle
+int hote_eeprom_fichier(const char *chemin);
+void hote_temps_reel(int entree, int sortie);
+
+#endif
@@ -0,0 +1,9 @@
+/*  Remplacement de <util/delay.h> pour la compilation hôte (x86_64).
+    Les délais ne bloquent pas : ils font avancer une horloge virtuelle (voir hote.h).  */
+#ifndef HOTE_UTIL_DELAY_H
+#define HOTE_UTIL_DELAY_H
+
+void _delay_ms(double ms);
+void _delay_us(double us);
+
+#endif
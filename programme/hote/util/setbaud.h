@@ -0,0 +1,10 @@
+/*  Remplacement de <util/setbaud.h> pour la compilation hôte (x86_64) : mêmes valeurs qu'avec avr-libc
+    pour BAUD = 115200 et F_CPU = 16 MHz.  */
+#ifndef HOTE_UTIL_SETBAUD_H
+#define HOTE_UTIL_SETBAUD_H
+
+#define UBRRH_VALUE 0
+#define UBRRL_VALUE 16
+#define USE_2X 1
+
+#endif
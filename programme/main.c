@@ -1,8 +1,11 @@
 #include <avr/io.h>         // Pour manipuler les registres du microcontrôleur
 #include <util/delay.h>     // Pour les fonctions de délai
 #include <avr/eeprom.h>     // Pour la gestion de la mémoire eeprom
+#include <avr/interrupt.h>  // Pour les interruptions (UART)
+#include <avr/sleep.h>      // Pour la mise en veille en attendant une interruption
 #include "uECC.h"           // Pour la librairie micro-ecc
-#include <stdlib.h>         // Pour rand()
+#include "sha256.h"         // Pour HMAC-SHA256 (fonction aléatoire, profil 'clés dérivées')
+#include <string.h>         // Pour memcmp()
 //  Macro et librairie pour le  calcul de UBRR (calcul via la formule crée des problème d'arrondis)
 #define BAUD 115200
 #include <util/setbaud.h>
@@ -10,11 +13,11 @@
 
 /*  SOMMAIRE : 
     1. Macros
-    2. Configuration UART (TP4)
+    2. Configuration UART (TP4) et tampons circulaires
     3. Configurations au démarrage
     4. Gestion du bouton et fonction de confirmation
     5. Gestion de la mémoire EEPROM
-    6. Fonction (pseudo-)aléatoire pour génération de clé et signature
+    6. Fonction (pseudo-)aléatoire pour génération de clé et signature, réserve de nonces
     7. Fonctions de gestion des resquetes reçues (MakeCredential, ...)
     8. Fonction main
     9. Tests
@@ -26,7 +29,75 @@
     |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|                                                     
  */
+/*  Profil de compilation 'debug' (make DEBUG=1) : active les diagnostics par clignotement de la LED.
+    Dans le profil normal ces clignotements (et leurs délais bloquants) ne sont pas compilés.  */
+#ifndef DEBUG_LED
+#define DEBUG_LED 0
+#endif
+
+#if DEBUG_LED
+//  Clignotement de diagnostic : LED allumée 200 ms puis éteinte 500 ms
+#define CLIGNOTEMENT_DEBUG() do {                                   \
+        PORTD |= (1 << LED_PIN);    /* Allume la LED */             \
+        _delay_ms(200);             /* Attente */                   \
+        PORTD &= ~(1 << LED_PIN);   /* Éteint la LED */             \
+        _delay_ms(500);             /* Attente */                   \
+    } while(0)
+#else
+#define CLIGNOTEMENT_DEBUG() do {} while(0)
+#endif
+
+/*  Profil 'clés dérivées' (make CLES_DERIVEES=1) : aucune clé privée n'est stockée. La clé privée et le credential_id
+    d'une application sont recalculés à partir de son app_id_hash et d'une clé maître de l'appareil (HMAC-SHA256, voir
+    partie 6) : nombre d'applications illimité, GET_ASSERTION sans aucune lecture de l'eeprom, et une seule écriture
+    (la clé maître, tirée au premier démarrage et à chaque RESET par la fonction aléatoire de la partie 6). GET_ASSERTION
+    ne transmet pas le credential_id, qui ne peut donc pas transporter la clé chiffrée. Il n'authentifie rien non plus :
+    l'appareil ne le reçoit jamais en retour, aucune vérification n'est faite ; c'est un simple identifiant, calculé à
+    partir de la clé maître pour que MAKE_CREDENTIAL et GET_ASSERTION renvoient le même.
+    En contrepartie, LIST_CREDENTIALS renvoie une liste vide, GET_ASSERTION répond pour toute application (jamais
+    STATUS_ERR_NOT_FOUND) et un nouveau MAKE_CREDENTIAL pour une même application redonne la même paire de clés.  */
+#ifndef CLES_DERIVEES
+#define CLES_DERIVEES 0
+#endif
+
+/*  Profil 'effacement des clés' (make EFFACEMENT_CLES=1) : RESET ne fait que changer d'époque (voir partie 5), les
+    clés privées des entrées supprimées restent donc dans l'eeprom. Avec ce profil, la boucle principale les met à zéro
+    en tâche de fond, un octet par tour quand elle n'a rien d'autre à faire (voir effacement_progressif()).  */
+#ifndef EFFACEMENT_CLES
+#define EFFACEMENT_CLES 0
+#endif
+
+/*  Profil 'présence' (make PRESENCE=<secondes>, de 1 à 65) : après un appui qui confirme MAKE_CREDENTIAL ou
+    GET_ASSERTION, les MAKE_CREDENTIAL et GET_ASSERTION(S) des DUREE_PRESENCE secondes suivantes sont acceptés sans
+    demande de confirmation (ni clignotement, ni appui). Avec PRESENCE_PAR_APPLICATION (make PRESENCE_APP=1), seulement
+    pour l'application de l'appui. RESET demande toujours un appui, et ferme la fenêtre. Sans ce profil (0), chaque
+    commande attend son appui.  */
+#ifndef DUREE_PRESENCE
+#define DUREE_PRESENCE 0
+#endif
+#ifndef PRESENCE_PAR_APPLICATION
+#define PRESENCE_PAR_APPLICATION 0
+#endif
+#if DUREE_PRESENCE > 65
+#error "DUREE_PRESENCE : 65 secondes au plus (fenêtre comptée en ms sur 16 bits)"
+#endif
+
+/*  Repères de phase pour le banc d'essai simavr (make bench, voir bench/bench_simavr.c) : le numéro de la phase en
+    cours est écrit dans GPIOR0, registre libre de l'atmega328p (ldi + out, 2 cycles). Le simulateur relève le compteur
+    de cycles à chaque écriture, ce qui découpe chaque commande sans modifier son déroulement.  */
+#define PHASE_REPOS 0           // Boucle principale : veille, remplissage de la réserve de nonces
+#define PHASE_LECTURE 1         // Réception et lecture de la requête
+#define PHASE_RECHERCHE 2       // Accès à l'eeprom : recherche, sauvegarde, suppression
+#define PHASE_CRYPTO 3          // Génération de la paire de clés, signature
+#define PHASE_CONFIRMATION 4    // Attente de l'appui (LED clignotante)
+#define PHASE_REPONSE 5         // Dépôt de la réponse dans le tampon d'émission
+#define PHASE_DEMARRAGE 6       // config() : la collecte d'entropie met aussi la carte en veille
+#define PHASE(numero) (GPIOR0 = (numero))
+
 int avr_rng(uint8_t *dest, unsigned size);  // Fonction aléatoire pour uECC_make_key() et uECC_sign()
+void initialisation_aleatoire();            // Entropie et graine de avr_rng() (partie 6)
+void chargement_magasin();                  // État du magasin des entrées en SRAM (partie 5)
+void chargement_cle_maitre();               // Clé maître du profil 'clés dérivées' (partie 6)
 
 #define LED_PIN PD4     // LED sur la broche 4 (PD4 sur Arduino Uno)
 #define BUTTON_PIN PD2  // Bouton poussoir sur la broche 2 (PD2 sur Arduino Uno)
@@ -44,6 +115,9 @@ int avr_rng(uint8_t *dest, unsigned size);  // Fonction aléatoire pour uECC_mak
 #define COMMAND_MAKE_CREDENTIAL 1
 #define COMMAND_GET_ASSERTION 2
 #define COMMAND_RESET 3
+#define COMMAND_SET_BAUD 4
+#define COMMAND_LIST_PAGE 5
+#define COMMAND_GET_ASSERTIONS 6
 
 // Codes erreurs
 #define STATUS_OK 0
@@ -56,7 +130,7 @@ int avr_rng(uint8_t *dest, unsigned size);  // Fonction aléatoire pour uECC_mak
 
 /*  |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|
-    |                                       2. CONFIGURATION UART (TP4)                                              |   
+    |                         2. CONFIGURATION UART (TP4) ET TAMPONS CIRCULAIRES                                     |   
     |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|                                                     
  */
@@ -70,18 +144,140 @@ void UART__init() {
     UCSR0A &= ~(1 << U2X0); // Mode normal
     #endif
 
-    UCSR0B = (1 << RXEN0) | (1 << TXEN0);   // Activation de la réception et de la transmission
+    // Activation de la réception et de la transmission, et de l'interruption de réception
+    UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00); // Format de trame : 8 bits de données, 1 bit de stop
 }
 
+/*  Vitesses de la liaison (commande SET_BAUD), repérées par un code : 0 = 115200 (vitesse de démarrage, UBRR calculé
+    par setbaud.h) puis 250k, 500k, 1M et 2M bauds. En double vitesse (U2X0) à 16 MHz, ces quatre dernières sont des
+    diviseurs exacts de F_CPU/8 : UBRR = F_CPU/(8*baud) - 1 = 7, 3, 1 et 0, sans aucune erreur de baudrate.  */
+#define NB_VITESSES 5
+#define VITESSE_DEMARRAGE 0
+#define UBRR_2X(baud) ((F_CPU / 8 / (baud)) - 1)
+
+//  Changement de vitesse de la liaison (le tampon d'émission doit être vide, voir UART__vidage())
+void UART__vitesse(uint8_t code) {
+    if (code == VITESSE_DEMARRAGE) {
+        UBRR0H = UBRRH_VALUE;
+        UBRR0L = UBRRL_VALUE;
+        #if USE_2X
+        UCSR0A |= (1 << U2X0);
+        #else
+        UCSR0A &= ~(1 << U2X0);
+        #endif
+        return;
+    }
+    static const uint8_t ubrr[NB_VITESSES] = {0, UBRR_2X(250000), UBRR_2X(500000), UBRR_2X(1000000), UBRR_2X(2000000)};
+    UBRR0H = 0;
+    UBRR0L = ubrr[code];
+    UCSR0A |= (1 << U2X0);
+}
+
+/*  La réception et l'émission se font par interruptions (USART_RX et USART_UDRE) dans deux tampons circulaires.
+    Le programme n'attend donc plus l'UART octet par octet : une réponse est déposée dans le tampon d'émission
+    et part pendant que le programme continue, et les octets reçus pendant un calcul (signature, confirmation, ...)
+    sont conservés jusqu'à leur lecture. Les tailles doivent être des puissances de 2. Le tampon de réception contient
+    une requête entière, même envoyée pendant un calcul (GET_ASSERTIONS : 102 octets au plus, voir LOT_MAX).  */
+#define UART_TAILLE_RX 128
+#define UART_TAILLE_TX 64   // Une réponse GET_ASSERTION (57 octets) tient entièrement dans le tampon
+
+volatile uint8_t uart_rx[UART_TAILLE_RX];
+volatile uint8_t uart_rx_debut = 0;     // Prochain octet à lire (programme)
+volatile uint8_t uart_rx_fin = 0;       // Prochaine case libre (interruption)
+volatile uint8_t uart_tx[UART_TAILLE_TX];
+volatile uint8_t uart_tx_debut = 0;     // Prochain octet à envoyer (interruption)
+volatile uint8_t uart_tx_fin = 0;       // Prochaine case libre (programme)
+volatile uint8_t uart_octets_perdus = 0; // Octets reçus alors que le tampon de réception était plein
+
+//  Interruption 'octet reçu' : rangement dans le tampon de réception
+ISR(USART_RX_vect){
+    uint8_t octet = UDR0;
+    uint8_t suivant = (uart_rx_fin + 1) & (UART_TAILLE_RX - 1);
+    if(suivant != uart_rx_debut){
+        uart_rx[uart_rx_fin] = octet;
+        uart_rx_fin = suivant;
+    }
+    else{
+        uart_octets_perdus++;   // Tampon plein
+    }
+}
+
+//  Interruption 'registre d'émission vide' : envoi du prochain octet du tampon d'émission
+ISR(USART_UDRE_vect){
+    if(uart_tx_debut != uart_tx_fin){
+        UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);  // Efface TXC0 (voir UART__vidage())
+        UDR0 = uart_tx[uart_tx_debut];
+        uart_tx_debut = (uart_tx_debut + 1) & (UART_TAILLE_TX - 1);
+    }
+    if(uart_tx_debut == uart_tx_fin){
+        UCSR0B &= ~(1 << UDRIE0);   // Plus rien à envoyer : on coupe l'interruption
+    }
+}
+
+//  Mise en veille jusqu'à la prochaine interruption. À appeler avec les interruptions désactivées (cli()) après avoir
+//  testé la condition attendue : sei() suivi de sleep_cpu() ne laisse passer aucune interruption entre les deux.
+void veille(){
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+    cli();
+}
+
+//  Nombre d'octets reçus en attente de lecture (non bloquant)
+uint8_t UART__disponible() {
+    return (uart_rx_fin - uart_rx_debut) & (UART_TAILLE_RX - 1);
+}
+
+//  Lecture d'un octet reçu s'il y en a un (non bloquant). Renvoie 1 si un octet a été lu, 0 sinon
+uint8_t UART__lire(uint8_t *octet) {
+    if(uart_rx_debut == uart_rx_fin){
+        return 0;
+    }
+    *octet = uart_rx[uart_rx_debut];
+    uart_rx_debut = (uart_rx_debut + 1) & (UART_TAILLE_RX - 1);
+    return 1;
+}
+
+//  Dépôt d'un octet dans le tampon d'émission (non bloquant). Renvoie 1 si l'octet a été déposé, 0 si le tampon est plein
+uint8_t UART__ecrire(uint8_t octet) {
+    uint8_t suivant = (uart_tx_fin + 1) & (UART_TAILLE_TX - 1);
+    if(suivant == uart_tx_debut){
+        return 0;
+    }
+    uart_tx[uart_tx_fin] = octet;
+    uart_tx_fin = suivant;
+    UCSR0B |= (1 << UDRIE0);    // L'interruption d'émission prend le relais
+    return 1;
+}
+
 uint8_t UART__getc() {
-    while (!(UCSR0A & (1 << RXC0)));    // Attente jusqu'à réception d'un caractère
-    return UDR0;                        // Retourne le caractère reçu
+    uint8_t octet;
+    cli();
+    while (!UART__lire(&octet)) {   // Attente (en veille) jusqu'à réception d'un caractère
+        veille();
+    }
+    sei();
+    return octet;                   // Retourne le caractère reçu
 }
 
 void UART__putc(uint8_t data) {
-    while (!(UCSR0A & (1 << UDRE0))); // Attente jusqu'à ce que le buffer de transmission soit prêt
-    UDR0 = data;                      // Envoi du caractère
+    cli();
+    while (!UART__ecrire(data)) {   // Attente (en veille) d'une place dans le tampon d'émission
+        veille();
+    }
+    sei();
+}
+
+//  Attente de l'envoi complet du tampon d'émission (dernier octet compris)
+void UART__vidage() {
+    cli();
+    while (UCSR0B & (1 << UDRIE0)) {        // L'interruption d'émission se coupe quand le tampon est vide
+        veille();
+    }
+    sei();
+    while (!(UCSR0A & (1 << TXC0)));        // Le dernier octet est sorti du registre à décalage
 }
 
 /*  |----------------------------------------------------------------------------------------------------------------|
@@ -92,6 +288,8 @@ void UART__putc(uint8_t data) {
  */
 //  Diverses configurations au démarrage
 void config(){
+    PHASE(PHASE_DEMARRAGE);
+
     //  Initialisation des broches
     DDRD |= (1 << LED_PIN);     // Configurer PD4 comme sortie pour la led
     DDRD &= ~(1 << BUTTON_PIN); // Configurer PD2 comme entrée pour le bouton
@@ -104,6 +302,18 @@ void config(){
 
     //  Configuration USART
     UART__init();   // Initialisation périphérique UART
+    set_sleep_mode(SLEEP_MODE_IDLE);    // La veille 'idle' laisse l'UART et le Timer2 fonctionner
+
+    //  Timer2 : interruption toutes les millisecondes (mode CTC, 16 MHz / 64 / 250 = 1 kHz) pour le bouton et la LED
+    TCCR2A = (1 << WGM21);
+    TCCR2B = (1 << CS22);       // Prédiviseur 64
+    OCR2A = 249;
+    TIMSK2 = (1 << OCIE2A);
+
+    sei();          // Activation des interruptions (UART et Timer2)
+
+    //  État et répertoire du magasin des entrées en SRAM (recherche et liste sans lecture de l'eeprom)
+    chargement_magasin();
 
     PORTD |= (1 << LED_PIN);    // Allume la LED
     _delay_ms(200);             // Attente
@@ -111,7 +321,14 @@ void config(){
     _delay_ms(500);             // Attente
 
     // Configuration de la fonction aléatoire pour les fonctions de génération de clé et de signature
+    initialisation_aleatoire();     // Collecte d'entropie : environ 1 s (4 s au premier démarrage)
     uECC_set_rng(avr_rng);  
+
+    #if CLES_DERIVEES
+    chargement_cle_maitre();    // Tirée au premier démarrage (après l'initialisation de la fonction aléatoire)
+    #endif
+
+    PHASE(PHASE_REPOS);
 }
 
 /*  |----------------------------------------------------------------------------------------------------------------|
@@ -120,17 +337,32 @@ void config(){
     |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|                                                     
  */
+/*  Le bouton et la LED sont gérés par l'interruption du Timer2 (toutes les millisecondes) : l'état du bouton est lu et
+    filtré même pendant un calcul (recherche, signature), et la LED clignote sans que le programme ait à s'en occuper.  */
+#define SEUIL_DEBOUNCE 10           // Nombre de lectures (ms) d'un nouvel état stable avant de le prendre en compte
+#define DUREE_CONFIRMATION 10000    // Durée maximale de la demande de confirmation (ms)
+#define DEMI_PERIODE_LED 500        // La LED change d'état toutes les 500 ms pendant la demande de confirmation
+
 //  Variables permettant d'évaluer l'état du bouton
 volatile uint8_t bouton_etat = 1;         // État du bouton (1 = relâché, 0 = appuyé)
 volatile uint8_t bouton_compteur = 0;     // Compteur pour détecter la stabilité de l'état
 volatile uint8_t bouton_appuie = 0;       // flag indiquant un appui validé
-//  Fonction de debounce, permettant de détecter un appuie bouton (Voir partie 5 du TP5)
+
+volatile uint16_t millisecondes = 0;      // Horloge en ms (avancée par le Timer2, repasse à 0 toutes les 65 s)
+volatile uint8_t clignotement = 0;        // LED clignotante (demande de confirmation en cours)
+volatile uint16_t clignotement_ms = 0;    // Temps écoulé depuis le dernier changement d'état de la LED
+uint16_t confirmation_debut;              // Début de la demande de confirmation en cours (ms)
+#if DUREE_PRESENCE
+volatile uint16_t presence_restante = 0;  // Temps restant de la fenêtre de présence (ms, décompté par le Timer2)
+#endif
+
+//  Fonction de debounce, permettant de détecter un appuie bouton (Voir partie 5 du TP5). Appelée toutes les ms
 void debounce() {
     uint8_t current_state = PIND & (1 << BUTTON_PIN);   // Lire l'état actuel du bouton (PD2)
 
     if (current_state != bouton_etat) {       // Si l'état a changé
         bouton_compteur++;              // Incrémenter le compteur
-        if (bouton_compteur >= 4) {     // Si l'état est stable pendant 4 cycles
+        if (bouton_compteur >= SEUIL_DEBOUNCE) {     // Si l'état est stable pendant SEUIL_DEBOUNCE lectures
             bouton_etat = current_state;      // Mettre à jour l'état du bouton
             if (bouton_etat == 0) {     // Si le bouton est stable à l'état bas
                 bouton_appuie = 1;      // Signaler un appui validé
@@ -142,44 +374,122 @@ void debounce() {
     }
 }
 
+//  Interruption du Timer2 (1 kHz) : horloge, bouton et clignotement de la LED
+ISR(TIMER2_COMPA_vect) {
+    millisecondes++;
+    #if DUREE_PRESENCE
+    if (presence_restante) {
+        presence_restante--;
+    }
+    #endif
+    debounce();
+    if (clignotement && ++clignotement_ms >= DEMI_PERIODE_LED) {
+        clignotement_ms = 0;
+        PORTD ^= (1 << LED_PIN);    // Inverser l'état de la LED
+    }
+}
+
 //  Fonction de test du bouton (s'arrete pas)
 void test_bouton(){
     while(1) {
-        debounce();             // Appeler la fonction debounce régulièrement
-        if (bouton_appuie) {    // Si un appui validé est détecté
+        if (bouton_appuie) {    // Si un appui validé est détecté (debounce() dans l'interruption du Timer2)
             PORTD ^= (1 << LED_PIN); // Inverser l'état de la LED
             bouton_appuie = 0;  // Réinitialiser le drapeau
         }
-        _delay_ms(15);  // 'leger' délai pour limiter la fréquence des vérifications
     }
 }
 
-//  Fonction demandant la confirmation de l'utilisateur. (1 = user a confirmé, 0 = user a décliné)
-uint8_t demande_confirmation(){
-    //  boucle 'for' pour les 10 secondes d'attente (un i correspond à une seconde environ)
-    for(int i = 0; i < 10; i++){
-        PORTD ^= (1 << LED_PIN);        //  allumer la led pendant 0.5 seconde
-        for(int j = 0; j < 33 ; j++){   //  j va jusqu'à 33, car 500/15 = 33
-            debounce();
-            if(bouton_appuie){
-                bouton_appuie = 0;          //  reinitialiser le drapeau
-                PORTD ^= (1 << LED_PIN);    //  eteindre la led
-                return 1;                   //  confirmation obtenue
-            }
-            _delay_ms(15);
-        }
-        PORTD ^= (1 << LED_PIN);     //  eteindre la led pendant 0.5 seconde
-        for(int j = 0; j < 33 ; j++){
-            debounce();
-            if(bouton_appuie){
-                bouton_appuie = 0;   //  reinitialiser le drapeau
-                return 1;            //  confirmation obtenue
-            }
-            _delay_ms(15);
+/*  Demande de confirmation non bloquante : debut_confirmation() fait clignoter la LED et lance le délai de 10 secondes,
+    puis la boucle principale interroge etat_confirmation() à chaque tour et se met en veille entre deux tours (sans
+    préparer de nonce : voir tour_boucle()). Seul un appui après debut_confirmation() compte.  */
+#define CONFIRMATION_EN_ATTENTE 0
+#define CONFIRMATION_ACCEPTEE 1
+#define CONFIRMATION_REFUSEE 2
+
+#if DUREE_PRESENCE
+uint8_t presence_demandee = 0;      // Un appui sur la demande en cours ouvre la fenêtre de présence
+uint8_t presence_acquise = 0;       // Demande en cours acceptée d'avance (fenêtre de présence ouverte)
+#if PRESENCE_PAR_APPLICATION
+uint8_t presence_app_id[TAILLE_APP_ID_HASH];    // Application de la demande en cours, puis de la fenêtre
+uint8_t presence_app_fenetre[TAILLE_APP_ID_HASH];
+#endif
+#endif
+
+void debut_confirmation(){
+    cli();
+    #if DUREE_PRESENCE
+    presence_demandee = 0;
+    presence_acquise = 0;
+    #endif
+    bouton_appuie = 0;
+    confirmation_debut = millisecondes;
+    clignotement_ms = 0;
+    clignotement = 1;
+    sei();
+    PORTD |= (1 << LED_PIN);    // Allume la LED (première demi-période)
+}
+
+/*  Demande de confirmation de MAKE_CREDENTIAL ou GET_ASSERTION(S) pour l'application 'app_id_hash' : acceptée d'avance
+    si la fenêtre de présence est ouverte (profil 'présence'), sans clignotement. Sinon, demande normale, dont l'appui
+    ouvrira la fenêtre.  */
+void debut_confirmation_application(const uint8_t *app_id_hash){
+    #if DUREE_PRESENCE
+    uint8_t ouverte;
+    cli();
+    ouverte = (presence_restante != 0);
+    sei();
+    #if PRESENCE_PAR_APPLICATION
+    ouverte = ouverte && memcmp(app_id_hash, presence_app_fenetre, TAILLE_APP_ID_HASH) == 0;
+    #endif
+    if (ouverte) {
+        presence_acquise = 1;
+        return;
+    }
+    debut_confirmation();
+    presence_demandee = 1;
+    #if PRESENCE_PAR_APPLICATION
+    memcpy(presence_app_id, app_id_hash, TAILLE_APP_ID_HASH);
+    #endif
+    #else
+    (void)app_id_hash;
+    debut_confirmation();
+    #endif
+}
+
+//  État de la demande de confirmation en cours (non bloquant). La LED s'éteint dès que l'utilisateur a décidé
+uint8_t etat_confirmation(){
+    uint8_t etat = CONFIRMATION_EN_ATTENTE;
+    #if DUREE_PRESENCE
+    if (presence_acquise) {
+        presence_acquise = 0;
+        return CONFIRMATION_ACCEPTEE;   // Fenêtre de présence ouverte : LED restée éteinte
+    }
+    #endif
+    cli();
+    if (bouton_appuie) {
+        bouton_appuie = 0;      //  reinitialiser le drapeau
+        etat = CONFIRMATION_ACCEPTEE;
+        #if DUREE_PRESENCE
+        if (presence_demandee) {
+            presence_restante = (uint16_t)DUREE_PRESENCE * 1000;    // Ouverture de la fenêtre de présence
+            #if PRESENCE_PAR_APPLICATION
+            memcpy(presence_app_fenetre, presence_app_id, TAILLE_APP_ID_HASH);
+            #endif
         }
+        #endif
+    }
+    else if ((uint16_t)(millisecondes - confirmation_debut) >= DUREE_CONFIRMATION) {
+        etat = CONFIRMATION_REFUSEE;    //  10 secondes sans appui
+    }
+    if (etat != CONFIRMATION_EN_ATTENTE) {
+        clignotement = 0;
     }
-    return 0;   //  l'utilisateur n'a pas confirmé
-}  
+    sei();
+    if (etat != CONFIRMATION_EN_ATTENTE) {
+        PORTD &= ~(1 << LED_PIN);   //  eteindre la led
+    }
+    return etat;
+}
 
 /*  |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|
@@ -187,109 +497,766 @@ uint8_t demande_confirmation(){
     |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|                                                     
  */
-// Derniere case afin d'indiquer la disponibilité (0 si c'est disponible et 255 si c'est occupé)
-#define TAILLE_ENTREE (TAILLE_APP_ID_HASH + TAILLE_CREDENTIAL_ID + TAILLE_CLE_PRIVE + 1)
-#define MAX_ENTREES 17  // correspond à 1000/TAILLE_ENTREE = 1000/57
+/*  Stockage des entrées en journal, avec répartition de l'usure. Un octet de l'eeprom de l'atmega328p supporte environ
+    100 000 écritures : l'ancienne disposition (entrées à la suite, compteur d'entrées et compteur de démarrages à des
+    adresses fixes) réécrivait toujours les mêmes octets, à chaque enregistrement, RESET et démarrage.
 
-uint8_t EEMEM donnees_eeprom[1000]; // Allocation d'une zone de stockage dans l'eeprom
-// Enregistrement du nombre d'entrée dans l'eeprom (pour pas se perdre dans les comptes après un redémarrage)
-uint8_t EEMEM compteur_eeprom = 0; 
+    Le magasin est découpé en MAX_ENTREES emplacements d'un enregistrement :
+        [état (1), numéro de séquence (3), app_id_hash (20), credential_id (16), clé privée (21)]
+    Les enregistrements sont écrits à tour de rôle dans les emplacements, comme un journal circulaire, en sautant ceux
+    qui contiennent une entrée en cours : les emplacements s'usent au même rythme. L'octet d'état est écrit en dernier :
+    une coupure pendant l'écriture laisse un emplacement libre, jamais une entrée tronquée. Le numéro de séquence
+    augmente à chaque nouvel enregistrement : il situe la fin du journal.
 
-//  Fonction permettant la sauvegarde d'une entrée dans la mémoire eeprom
-uint8_t sauvegarde_entree_eeprom(uint8_t* app_id_hash, uint8_t *credential_id, uint8_t *private_key){
-    uint8_t compteur = eeprom_read_byte(&compteur_eeprom);
-    if (compteur >= MAX_ENTREES){
-        return 0;   // code erreur 'Mémoire pleine'
+    L'octet d'état est la génération de l'enregistrement : l'époque en cours au moment de l'écriture. Seuls les
+    enregistrements de l'époque en cours (rangée dans l'en-tête) sont valides, les autres sont libres. RESET passe donc à
+    l'époque suivante en écrivant une seule cellule de l'en-tête, quel que soit le nombre d'entrées. Les époques vont de
+    EPOQUE_MIN à EPOQUE_MAX puis recommencent : avant d'en réutiliser une, RESET libère les éventuels enregistrements qui
+    la portent encore (écrits 254 RESET plus tôt et jamais réécrits depuis, en pratique aucun).
+
+    Une application déjà enregistrée (MAKE_CREDENTIAL répété) garde son emplacement : son entrée, retrouvée par l'index
+    en SRAM, est réécrite sur place et seuls les octets modifiés (en pratique la clé privée) sont écrits. Aucun doublon
+    ne s'accumule : la capacité et le coût d'une recherche ne dépendent pas du nombre de réenregistrements.
+
+    Ramasse-miettes : deux enregistrements valides d'une même application (magasin écrit par une version précédente,
+    où le nouvel enregistrement était ajouté au journal) sont départagés au démarrage par leur numéro de séquence. Le
+    plus ancien, périmé, reste valide dans l'eeprom jusqu'à ce que le journal repasse sur son emplacement, qui est alors
+    marqué libre (ETAT_LIBRE) avant d'être réécrit.
+
+    Au démarrage, chargement_magasin() reconstruit l'état en SRAM en lisant l'état et la séquence des emplacements, et
+    l'app_id_hash et le credential_id des enregistrements valides (répertoire en SRAM, voir plus bas) : un parcours
+    borné (au plus 640 octets lus), quel que soit l'historique des écritures.  */
+#define MAX_ENTREES 16
+#define ETAT_LIBRE 0x00     // Emplacement libre (et clé effacée, profil EFFACEMENT_CLES)
+#define ETAT_NEUF 0xFF      // Eeprom neuve : emplacement jamais écrit
+#define EPOQUE_MIN 0x01     // Autres valeurs de l'état : époque de l'enregistrement
+#define EPOQUE_MAX 0xFE
+
+// Position des champs dans un enregistrement
+#define ENR_ETAT 0
+#define ENR_SEQUENCE 1
+#define ENR_APP_ID_HASH 4
+#define ENR_CREDENTIAL_ID (ENR_APP_ID_HASH + TAILLE_APP_ID_HASH)
+#define ENR_CLE_PRIVE (ENR_CREDENTIAL_ID + TAILLE_CREDENTIAL_ID)
+#define TAILLE_ENTREE (ENR_CLE_PRIVE + TAILLE_CLE_PRIVE)    // 61 octets
+
+/*  Graine de la fonction aléatoire (partie 6), déclarée avant le magasin : gcc range les variables EEMEM dans l'ordre
+    inverse de leur déclaration (vérifié sur la compilation hôte), la graine vient donc après l'en-tête et le magasin,
+    dont les adresses ne changent pas. Eeprom : 30 + 976 + 16 = 1022 octets sur 1024. Usure : la graine n'est réécrite
+    que tous les PERIODE_GRAINE démarrages, comme une cellule de l'en-tête. Profil CLES_DERIVEES : pas de place pour la
+    graine à côté de la clé maître, qui en tient lieu (voir partie 6).  */
+#define TAILLE_GRAINE 16
+#define PERIODE_GRAINE 8
+#if !CLES_DERIVEES
+uint8_t EEMEM graine_eeprom[TAILLE_GRAINE];
+#endif
+
+uint8_t EEMEM magasin_eeprom[MAX_ENTREES][TAILLE_ENTREE];   // 16*61 = 976 octets
+
+/*  En-tête tournant : le compteur de démarrages (mélangé à l'état de la fonction aléatoire, partie 6) et l'époque en
+    cours. À chaque démarrage et à chaque RESET, le compteur est incrémenté et écrit dans la cellule qui suit la plus
+    récente, soit une écriture par cellule tous les NB_CELLULES_ENTETE démarrages. Une cellule : [compteur (3 octets),
+    époque, contrôle] ; une coupure pendant l'écriture la rend invalide et laisse la précédente en vigueur. Sans aucune
+    cellule valide, les entrées d'une ancienne disposition sont reprises (voir reprise_ancien_magasin()) ; une eeprom
+    neuve, ou une ancienne disposition sans entrée, est formatée.  */
+#define NB_CELLULES_ENTETE 6
+#define TAILLE_CELLULE 5
+#define CONTROLE_CELLULE 0x5A   // Contrôle = XOR des 4 premiers octets et de 0x5A (0xFF...FF et 0x00...00 invalides)
+
+uint8_t EEMEM entete_eeprom[NB_CELLULES_ENTETE][TAILLE_CELLULE];   // 30 octets
+
+/*  État du magasin en SRAM (reconstruit au démarrage) : une empreinte d'un octet de l'app_id_hash par emplacement,
+    deux masques d'emplacements, et le répertoire des entrées (app_id_hash et credential_id de chaque emplacement
+    valide, 16 x 36 = 576 octets). Une recherche compare d'abord les empreintes des entrées en cours, puis l'app_id_hash
+    complet des candidates dans le répertoire, sans lire l'eeprom ; LIST_CREDENTIALS répond aussi depuis le répertoire.
+    Seule la clé privée reste uniquement dans l'eeprom, lue pour signer. Toute écriture du magasin met le répertoire à
+    jour en même temps que l'eeprom. Budget SRAM (2048 octets) : voir la règle main.elf du Makefile.  */
+uint8_t index_sram[MAX_ENTREES];
+uint8_t app_id_sram[MAX_ENTREES][TAILLE_APP_ID_HASH];
+uint8_t credential_id_sram[MAX_ENTREES][TAILLE_CREDENTIAL_ID];
+uint16_t emplacements_entrees = 0;  // Bit i : l'emplacement i contient une entrée en cours
+uint16_t emplacements_perimes = 0;  // Bit i : enregistrement périmé, encore valide dans l'eeprom
+uint8_t nombre_entrees = 0;
+uint8_t epoque_courante = EPOQUE_MIN;
+uint32_t sequence_courante = 0;     // Séquence du dernier enregistrement écrit
+#if EFFACEMENT_CLES
+uint16_t emplacements_a_effacer = 0;    // Bit i : clé d'un enregistrement supprimé, pas encore mise à zéro
+#endif
+uint8_t emplacement_suivant = 0;    // Prochain emplacement du journal
+
+/*  Écriture différentielle : comme eeprom_update_block(), seuls les octets qui changent sont programmés (environ 3,3 ms
+    d'effacement et d'écriture chacun). Toutes les écritures du magasin passent par là, et deux compteurs en SRAM
+    donnent l'usure réelle : octets demandés et octets effectivement programmés (lus par les bancs d'essai).  */
+uint32_t eeprom_octets_demandes = 0;
+uint32_t eeprom_octets_programmes = 0;
+
+void ecriture_eeprom(const uint8_t *source, uint8_t *destination, uint8_t taille){
+    eeprom_octets_demandes += taille;
+    for(uint8_t i=0; i<taille; i++){
+        if(eeprom_read_byte(destination + i) != source[i]){
+            eeprom_write_byte(destination + i, source[i]);
+            eeprom_octets_programmes++;
+        }
     }
+}
 
-    // Détection de la position du début de la nouvelle entrée dans 'donnees_eeprom'
-    uint16_t case_courante = compteur*TAILLE_ENTREE;
+void ecriture_octet_eeprom(uint8_t *destination, uint8_t valeur){
+    ecriture_eeprom(&valeur, destination, 1);
+}
 
-    // Ecriture dans l'eeprom
-    eeprom_write_block(app_id_hash, &donnees_eeprom[case_courante], TAILLE_APP_ID_HASH);
-    eeprom_write_block(credential_id, &donnees_eeprom[case_courante + TAILLE_APP_ID_HASH], TAILLE_CREDENTIAL_ID);
-    eeprom_write_block(private_key, &donnees_eeprom[case_courante + TAILLE_APP_ID_HASH + TAILLE_CREDENTIAL_ID], TAILLE_CLE_PRIVE);
+//  Empreinte d'un app_id_hash : XOR de ses 20 octets (SHA1 est uniforme, donc l'empreinte l'est aussi)
+uint8_t empreinte_app_id(const uint8_t *app_id_hash){
+    uint8_t empreinte = 0;
+    for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+        empreinte ^= app_id_hash[i];
+    }
+    return empreinte;
+}
 
-    // Sans oublier de marquer que cette zone est désormais occupée
-    eeprom_write_byte(&donnees_eeprom[case_courante + TAILLE_ENTREE - 1], 0xFF);
+//  Lecture d'un compteur de 3 octets (poids faible en premier)
+uint32_t lecture_24bits(const uint8_t *adresse){
+    uint8_t octets[3];
+    eeprom_read_block(octets, adresse, 3);
+    return octets[0] | ((uint32_t)octets[1] << 8) | ((uint32_t)octets[2] << 16);
+}
 
-    // Et de mettre à jour le nombre d'entrées enregistrées dans l'eeprom
-    eeprom_write_byte(&compteur_eeprom, compteur + 1);
+//  Cellule la plus récente de l'en-tête (compteur le plus grand, avec son époque), -1 si aucune cellule n'est valide
+int8_t cellule_recente(uint32_t *compteur, uint8_t *epoque){
+    uint8_t cellule[TAILLE_CELLULE];
+    int8_t recente = -1;
+    for(int8_t i=0; i<NB_CELLULES_ENTETE; i++){
+        eeprom_read_block(cellule, entete_eeprom[i], TAILLE_CELLULE);
+        if((cellule[0] ^ cellule[1] ^ cellule[2] ^ cellule[3] ^ CONTROLE_CELLULE) != cellule[4]){
+            continue;
+        }
+        uint32_t valeur = cellule[0] | ((uint32_t)cellule[1] << 8) | ((uint32_t)cellule[2] << 16);
+        if(recente < 0 || valeur > *compteur){
+            *compteur = valeur;
+            *epoque = cellule[3];
+            recente = i;
+        }
+    }
+    return recente;
+}
 
-    return 1; // Enregistrement réussi
+void ecriture_cellule(uint8_t numero, uint32_t compteur, uint8_t epoque){
+    uint8_t cellule[TAILLE_CELLULE];
+    cellule[0] = compteur;
+    cellule[1] = compteur >> 8;
+    cellule[2] = compteur >> 16;
+    cellule[3] = epoque;
+    cellule[4] = cellule[0] ^ cellule[1] ^ cellule[2] ^ cellule[3] ^ CONTROLE_CELLULE;
+    ecriture_eeprom(cellule, entete_eeprom[numero], TAILLE_CELLULE);  // En pratique 2 octets : poids faible et contrôle
 }
 
-//  Permet de faire une recherche de clé à partir de l'id app haché (remplit credential_id et private_key)
-uint8_t recherche_entree_eeprom(uint8_t* app_id_hash, uint8_t *credential_id, uint8_t *private_key){
-    uint8_t compteur = eeprom_read_byte(&compteur_eeprom);
-    uint8_t lecture_actuelle;
-    uint16_t case_courante;
-    uint8_t etat_correspondance;
-    for(int i=0; i<compteur; i++){
-        PORTD |= (1 << LED_PIN); // Allume la LED
-        _delay_ms(200);     // Attente 
-        PORTD &= ~(1 << LED_PIN); // Éteint la LED
-        _delay_ms(500);     // Attente 
-
-        etat_correspondance = 1;
-        case_courante = i*TAILLE_ENTREE;
-        for(int j=0; j<TAILLE_APP_ID_HASH; j++){
-            lecture_actuelle = eeprom_read_byte(&donnees_eeprom[case_courante + j]);
-            if(app_id_hash[j] != lecture_actuelle){
-                etat_correspondance = 0;
+//  Nouveau démarrage : compteur incrémenté dans la cellule suivante de l'en-tête. Renvoie le nouveau compteur
+uint32_t nouveau_demarrage(){
+    uint32_t compteur = 0;
+    uint8_t epoque = EPOQUE_MIN;
+    int8_t recente = cellule_recente(&compteur, &epoque);
+    compteur = (recente < 0) ? 1 : compteur + 1;
+    ecriture_cellule((recente + 1) % NB_CELLULES_ENTETE, compteur, epoque);
+    return compteur;
+}
+
+//  Mise à jour du nombre d'entrées à partir du masque des entrées en cours
+void comptage_entrees(){
+    nombre_entrees = 0;
+    for(uint8_t e=0; e<MAX_ENTREES; e++){
+        nombre_entrees += (emplacements_entrees >> e) & 1;
+    }
+}
+
+#if !CLES_DERIVEES
+/*  Anciennes dispositions du magasin (versions précédentes du programme) : jusqu'à 17 entrées de 58 octets à la suite,
+        [app_id_hash (20), credential_id (16), clé privée (21), occupation (0xFF : entrée en cours)]
+    juste après le compteur d'entrées. Selon la version, l'index des empreintes (17 octets) et le compteur de démarrages
+    (4 octets) précèdent le compteur. Positions depuis le début de l'eeprom, où est rangé l'en-tête (ordre inverse des
+    déclarations EEMEM, comme plus haut). Profil CLES_DERIVEES : aucune entrée rangée, rien à reprendre.  */
+#define ANCIENNE_TAILLE_ENTREE 58
+#define ANCIEN_MAX_ENTREES 17
+#define ANCIEN_OCCUPE 0xFF
+#define ANCIEN_COMPTEUR_INDEX_DEMARRAGES 21     // Démarrages 0 à 3, index 4 à 20, compteur 21
+#define ANCIEN_INDEX_DEMARRAGES 4
+#define ANCIEN_COMPTEUR_INDEX 17                // Index 0 à 16, compteur 17
+#define ANCIEN_INDEX 0
+#define ANCIEN_COMPTEUR 0                       // Version d'origine : compteur 0, sans index
+#define SANS_INDEX -1
+
+//  Adresse de l'ancienne entrée 'i' dont le compteur est à la position 'compteur'
+uint8_t *ancienne_entree(uint8_t compteur, uint8_t i){
+    return (uint8_t *)entete_eeprom + compteur + 1 + i * ANCIENNE_TAILLE_ENTREE;
+}
+
+/*  Nombre d'entrées d'une ancienne disposition (compteur et index aux positions données), 0 si l'eeprom ne la contient
+    pas : chaque entrée comptée doit être occupée, avoir un app_id_hash écrit (pas seulement des 0xFF) et, s'il y a un
+    index, l'empreinte de son app_id_hash. L'app_id_hash et le credential_id sont lus dans le répertoire en SRAM.  */
+uint8_t entrees_ancien_magasin(uint8_t compteur, int8_t index){
+    uint8_t *eeprom = (uint8_t *)entete_eeprom;
+    uint8_t nombre = eeprom_read_byte(eeprom + compteur);
+    if(nombre == 0 || nombre > ANCIEN_MAX_ENTREES){
+        return 0;
+    }
+    for(uint8_t i=0; i<nombre && i<MAX_ENTREES; i++){
+        uint8_t *entree = ancienne_entree(compteur, i);
+        uint8_t et = 0xFF;
+        if(eeprom_read_byte(entree + ANCIENNE_TAILLE_ENTREE - 1) != ANCIEN_OCCUPE){
+            return 0;
+        }
+        eeprom_read_block(app_id_sram[i], entree, TAILLE_APP_ID_HASH);
+        eeprom_read_block(credential_id_sram[i], entree + TAILLE_APP_ID_HASH, TAILLE_CREDENTIAL_ID);
+        for(uint8_t j=0; j<TAILLE_APP_ID_HASH; j++){
+            et &= app_id_sram[i][j];
+        }
+        if(et == 0xFF || (index != SANS_INDEX && eeprom_read_byte(eeprom + index + i) != empreinte_app_id(app_id_sram[i]))){
+            return 0;
+        }
+    }
+    return nombre;
+}
 
-                PORTD |= (1 << LED_PIN); // Allume la LED
-                _delay_ms(200);     // Attente 
-                PORTD &= ~(1 << LED_PIN); // Éteint la LED
-                _delay_ms(500);     // Attente
+/*  Reprise d'une ancienne disposition au premier démarrage après la mise à jour (aucune cellule valide dans l'en-tête) :
+    les entrées sont recopiées dans les emplacements au lieu d'être perdues. L'entrée i va dans l'emplacement i avec la
+    séquence i + 1 : l'ordre d'enregistrement est conservé (doublons départagés comme au chargement). Recopie de la
+    dernière à la première : l'emplacement e commence après la fin de l'ancienne entrée e - 1, il ne recouvre que des
+    entrées déjà recopiées et l'entrée e elle-même, dont la clé est lue juste avant (l'app_id_hash et le credential_id
+    sont déjà dans le répertoire en SRAM). L'en-tête, qui recouvre l'ancien compteur, n'est écrit qu'ensuite, par
+    chargement_magasin(). Limites : une 17e entrée (ancien magasin plein) n'a pas d'emplacement et est perdue ; une
+    coupure pendant la reprise (une seule fois, environ 3 s pour 16 entrées) rend l'ancien magasin illisible, formaté au
+    démarrage suivant. Renvoie le nombre d'entrées reprises.  */
+uint8_t reprise_ancien_magasin(){
+    uint8_t compteur = ANCIEN_COMPTEUR_INDEX_DEMARRAGES;
+    uint8_t nombre = entrees_ancien_magasin(compteur, ANCIEN_INDEX_DEMARRAGES);
+    uint8_t private_key[TAILLE_CLE_PRIVE];
+    uint8_t sequence[3] = {0, 0, 0};
 
-                break;
+    if(nombre == 0){
+        compteur = ANCIEN_COMPTEUR_INDEX;
+        nombre = entrees_ancien_magasin(compteur, ANCIEN_INDEX);
+    }
+    if(nombre == 0){
+        compteur = ANCIEN_COMPTEUR;
+        nombre = entrees_ancien_magasin(compteur, SANS_INDEX);
+    }
+    if(nombre > MAX_ENTREES){
+        nombre = MAX_ENTREES;
+    }
+    for(int8_t e=nombre-1; e>=0; e--){
+        eeprom_read_block(private_key, ancienne_entree(compteur, e) + TAILLE_APP_ID_HASH + TAILLE_CREDENTIAL_ID,
+                          TAILLE_CLE_PRIVE);
+        sequence[0] = e + 1;
+        ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], ETAT_LIBRE);
+        ecriture_eeprom(sequence, &magasin_eeprom[e][ENR_SEQUENCE], 3);
+        ecriture_eeprom(app_id_sram[e], &magasin_eeprom[e][ENR_APP_ID_HASH], TAILLE_APP_ID_HASH);
+        ecriture_eeprom(credential_id_sram[e], &magasin_eeprom[e][ENR_CREDENTIAL_ID], TAILLE_CREDENTIAL_ID);
+        ecriture_eeprom(private_key, &magasin_eeprom[e][ENR_CLE_PRIVE], TAILLE_CLE_PRIVE);
+        ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], EPOQUE_MIN);
+    }
+    return nombre;
+}
+#endif
+
+//  Reconstruction de l'état du magasin en SRAM (au démarrage), après reprise d'une ancienne disposition ou formatage si
+//  l'en-tête n'est pas valide
+void chargement_magasin(){
+    uint32_t sequences[MAX_ENTREES];
+    uint16_t valides = 0;
+    uint32_t compteur;
+    uint8_t formatage = (cellule_recente(&compteur, &epoque_courante) < 0);
+    uint8_t reprises = 0;   // Emplacements écrits par la reprise, chargés normalement
+
+    if(formatage){
+        epoque_courante = EPOQUE_MIN;
+        #if !CLES_DERIVEES
+        reprises = reprise_ancien_magasin();
+        #endif
+    }
+    sequence_courante = 0;
+    emplacement_suivant = 0;
+    #if EFFACEMENT_CLES
+    emplacements_a_effacer = 0;
+    #endif
+    for(uint8_t e=0; e<MAX_ENTREES; e++){
+        uint8_t etat = eeprom_read_byte(&magasin_eeprom[e][ENR_ETAT]);
+        if(formatage && e >= reprises){
+            if(etat != ETAT_NEUF){
+                ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], ETAT_LIBRE);   // Reste de l'ancienne disposition
             }
+            continue;
         }
-        if(etat_correspondance == 1){
-            for(int i=0; i<TAILLE_CREDENTIAL_ID; i++){
-                credential_id[i] = eeprom_read_byte(&donnees_eeprom[case_courante + TAILLE_APP_ID_HASH + i]);
+        if(etat == ETAT_NEUF){
+            continue;   // Jamais écrit
+        }
+        #if EFFACEMENT_CLES
+        if(etat != ETAT_LIBRE && etat != epoque_courante){
+            emplacements_a_effacer |= (1u << e);     // Supprimé (RESET) mais clé pas encore effacée
+        }
+        #endif
+
+        //  La fin du journal suit l'enregistrement le plus récent, libéré ou non
+        sequences[e] = lecture_24bits(&magasin_eeprom[e][ENR_SEQUENCE]);
+        if(sequences[e] >= sequence_courante){
+            sequence_courante = sequences[e];
+            emplacement_suivant = (e + 1) % MAX_ENTREES;
+        }
+        if(etat == epoque_courante){
+            valides |= (1u << e);
+            eeprom_read_block(app_id_sram[e], &magasin_eeprom[e][ENR_APP_ID_HASH], TAILLE_APP_ID_HASH);
+            eeprom_read_block(credential_id_sram[e], &magasin_eeprom[e][ENR_CREDENTIAL_ID], TAILLE_CREDENTIAL_ID);
+            index_sram[e] = empreinte_app_id(app_id_sram[e]);
+        }
+    }
+
+    //  Deux enregistrements d'une même application (version précédente du magasin) : le plus ancien est périmé
+    emplacements_entrees = valides;
+    emplacements_perimes = 0;
+    for(uint8_t i=0; i<MAX_ENTREES; i++){
+        for(uint8_t j=i+1; j<MAX_ENTREES; j++){
+            if(!(emplacements_entrees & (1u << i)) || !(emplacements_entrees & (1u << j)) || index_sram[i] != index_sram[j]){
+                continue;
             }
-            for(int i=0; i<TAILLE_CLE_PRIVE; i++){
-                private_key[i] = eeprom_read_byte(&donnees_eeprom[case_courante + TAILLE_APP_ID_HASH + TAILLE_CREDENTIAL_ID + i]);
+            if(memcmp(app_id_sram[i], app_id_sram[j], TAILLE_APP_ID_HASH) == 0){
+                uint8_t ancien = (sequences[i] < sequences[j]) ? i : j;
+                emplacements_entrees &= ~(1u << ancien);
+                emplacements_perimes |= (1u << ancien);
             }
-            return 1;   // Succès de la recherche
         }
     }
-        return 0;   // Aucune correspondande
+    comptage_entrees();
+    #if EFFACEMENT_CLES
+    emplacements_a_effacer |= emplacements_perimes;
+    #endif
+
+    //  Magasin formaté ou repris : l'en-tête devient valide tout de suite (compteur 0, avant le premier démarrage compté)
+    if(formatage){
+        ecriture_cellule(0, 0, epoque_courante);
+    }
 }
 
-//  Suppression de toutes les entrées existantes (pour Reset)
+//  Emplacement de l'entrée en cours d'une application, -1 si elle n'est pas enregistrée
+int8_t emplacement_entree(const uint8_t *app_id_hash){
+    uint8_t empreinte = empreinte_app_id(app_id_hash);
+    for(int8_t e=0; e<MAX_ENTREES; e++){
+        // Les emplacements sans entrée et les empreintes différentes sont écartés d'abord
+        if(!(emplacements_entrees & (1u << e)) || index_sram[e] != empreinte){
+            continue;
+        }
+
+        CLIGNOTEMENT_DEBUG();   // Diagnostic (profil debug) : une entrée candidate
+
+        // Entrée candidate : vérification de l'app_id_hash complet (répertoire en SRAM)
+        if(memcmp(app_id_sram[e], app_id_hash, TAILLE_APP_ID_HASH) == 0){
+            return e;
+        }
+        CLIGNOTEMENT_DEBUG();   // Diagnostic (profil debug) : la candidate ne correspond pas (collision d'empreinte)
+    }
+    return -1;
+}
+
+/*  Remplacement sur place de l'entrée d'une application déjà enregistrée. L'emplacement est marqué libre le temps de
+    l'écriture (une coupure perd l'entrée mais ne laisse pas une clé à moitié écrite), et seuls les octets qui changent
+    sont programmés (ecriture_eeprom()) : l'app_id_hash et la séquence ne bougent pas, le credential_id (troncature de
+    l'app_id_hash) non plus.  */
+void remplacement_entree(uint8_t e, uint8_t *credential_id, uint8_t *private_key){
+    ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], ETAT_LIBRE);
+    ecriture_eeprom(credential_id, &magasin_eeprom[e][ENR_CREDENTIAL_ID], TAILLE_CREDENTIAL_ID);
+    ecriture_eeprom(private_key, &magasin_eeprom[e][ENR_CLE_PRIVE], TAILLE_CLE_PRIVE);
+    ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], epoque_courante);
+    memcpy(credential_id_sram[e], credential_id, TAILLE_CREDENTIAL_ID);
+}
+
+/*  Fonction permettant la sauvegarde d'une entrée dans la mémoire eeprom : remplacement sur place si l'application est
+    déjà enregistrée, ajout à la fin du journal sinon.  */
+uint8_t sauvegarde_entree_eeprom(uint8_t* app_id_hash, uint8_t *credential_id, uint8_t *private_key){
+    int8_t ancien = emplacement_entree(app_id_hash);
+    uint8_t e = emplacement_suivant;
+    uint8_t sequence[3];
+
+    if(ancien >= 0){
+        remplacement_entree(ancien, credential_id, private_key);
+        return 1;
+    }
+
+    // Prochain emplacement du journal sans entrée en cours (libre ou périmé)
+    for(uint8_t i=0; i<MAX_ENTREES && (emplacements_entrees & (1u << e)); i++){
+        e = (e + 1) % MAX_ENTREES;
+    }
+    if(emplacements_entrees & (1u << e)){
+        return 0;   // code erreur 'Mémoire pleine'
+    }
+
+    // Ramasse-miettes : un enregistrement périmé est libéré avant d'être réécrit
+    if(emplacements_perimes & (1u << e)){
+        ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], ETAT_LIBRE);
+    }
+    #if EFFACEMENT_CLES
+    emplacements_a_effacer &= ~(1u << e);    // L'ancienne clé est remplacée par la nouvelle
+    #endif
+
+    // Ecriture dans l'eeprom, l'état en dernier : l'entrée n'est visible qu'une fois complète
+    sequence_courante++;
+    sequence[0] = sequence_courante;
+    sequence[1] = sequence_courante >> 8;
+    sequence[2] = sequence_courante >> 16;
+    ecriture_eeprom(sequence, &magasin_eeprom[e][ENR_SEQUENCE], 3);
+    ecriture_eeprom(app_id_hash, &magasin_eeprom[e][ENR_APP_ID_HASH], TAILLE_APP_ID_HASH);
+    ecriture_eeprom(credential_id, &magasin_eeprom[e][ENR_CREDENTIAL_ID], TAILLE_CREDENTIAL_ID);
+    ecriture_eeprom(private_key, &magasin_eeprom[e][ENR_CLE_PRIVE], TAILLE_CLE_PRIVE);
+    ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], epoque_courante);
+
+    // Mise à jour de l'état en SRAM
+    emplacements_entrees |= (1u << e);
+    emplacements_perimes &= ~(1u << e);
+    index_sram[e] = empreinte_app_id(app_id_hash);
+    memcpy(app_id_sram[e], app_id_hash, TAILLE_APP_ID_HASH);
+    memcpy(credential_id_sram[e], credential_id, TAILLE_CREDENTIAL_ID);
+    emplacement_suivant = (e + 1) % MAX_ENTREES;
+    comptage_entrees();
+
+    return 1; // Enregistrement réussi
+}
+
+//  Permet de faire une recherche de clé à partir de l'id app haché (remplit credential_id et private_key). Seule la clé
+//  privée est lue dans l'eeprom
+uint8_t recherche_entree_eeprom(uint8_t* app_id_hash, uint8_t *credential_id, uint8_t *private_key){
+    int8_t e = emplacement_entree(app_id_hash);
+    if(e < 0){
+        return 0;   // Aucune correspondance
+    }
+    memcpy(credential_id, credential_id_sram[e], TAILLE_CREDENTIAL_ID);
+    eeprom_read_block(private_key, &magasin_eeprom[e][ENR_CLE_PRIVE], TAILLE_CLE_PRIVE);
+    return 1;   // Succès de la recherche
+}
+
+/*  Suppression de toutes les entrées existantes (pour Reset) : passage à l'époque suivante, une seule cellule de
+    l'en-tête écrite (entrées en cours et enregistrements périmés deviennent libres).  */
 void suppression_entrees_eeprom(){
-    uint8_t compteur = eeprom_read_byte(&compteur_eeprom);  // Nombre d'entrées
-    for(int i=1; i<=compteur; i++){
-        eeprom_write_byte(&donnees_eeprom[i * TAILLE_ENTREE + TAILLE_ENTREE - 1], 0x00);    // Marquage des entrées comme 'vides'
+    uint32_t compteur = 0;
+    uint8_t epoque;
+    int8_t recente = cellule_recente(&compteur, &epoque);
+    uint8_t suivante = (epoque_courante >= EPOQUE_MAX) ? EPOQUE_MIN : epoque_courante + 1;
+
+    // Enregistrements libres qui portent encore l'époque suivante (tour complet des époques) : libérés avant
+    for(uint8_t e=0; e<MAX_ENTREES; e++){
+        if(eeprom_read_byte(&magasin_eeprom[e][ENR_ETAT]) == suivante){
+            ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], ETAT_LIBRE);
+        }
     }
-    eeprom_write_byte(&compteur_eeprom, 0x00);  // Sans oublier de mettre le compteur à 0
+    ecriture_cellule((recente + 1) % NB_CELLULES_ENTETE, compteur + 1, suivante);
+    epoque_courante = suivante;
+
+    #if EFFACEMENT_CLES
+    emplacements_a_effacer |= emplacements_entrees | emplacements_perimes;
+    #endif
+    emplacements_entrees = 0;
+    emplacements_perimes = 0;
+    nombre_entrees = 0;
 }
 
+#if EFFACEMENT_CLES
+/*  Effacement progressif des clés supprimées (profil EFFACEMENT_CLES), appelé par la boucle principale quand elle n'a
+    rien d'autre à faire : un octet de clé mis à zéro par appel (3,3 ms), puis l'état à ETAT_LIBRE une fois toute la
+    clé effacée. Un emplacement dont l'état n'est ni libre ni de l'époque en cours est repris au démarrage : une coupure
+    n'interrompt l'effacement que jusqu'au prochain démarrage.  */
+void effacement_progressif(){
+    for(uint8_t e=0; e<MAX_ENTREES; e++){
+        if(!(emplacements_a_effacer & (1u << e))){
+            continue;
+        }
+        for(uint8_t i=0; i<TAILLE_CLE_PRIVE; i++){
+            if(eeprom_read_byte(&magasin_eeprom[e][ENR_CLE_PRIVE + i]) != 0x00){
+                ecriture_octet_eeprom(&magasin_eeprom[e][ENR_CLE_PRIVE + i], 0x00);
+                return;
+            }
+        }
+        ecriture_octet_eeprom(&magasin_eeprom[e][ENR_ETAT], ETAT_LIBRE);
+        emplacements_a_effacer &= ~(1u << e);
+        emplacements_perimes &= ~(1u << e);
+        return;
+    }
+}
+#endif
+
 /*  |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|
     |                               6. FONCTION (PSEUDO-)ALEATOIRE POUR micro-ecc                                    |   
     |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|                                                     
  */
+/*  Source d'entropie : la gigue entre l'oscillateur RC du chien de garde (128 kHz, indépendant du quartz) et le Timer1,
+    compteur libre cadencé par le quartz de 16 MHz. Le chien de garde, en mode interruption seule, réveille le programme
+    toutes les 16 ms environ et WDT_vect relève TCNT1 : d'un relevé à l'autre, les bits de poids faible varient avec la
+    gigue de l'oscillateur RC. On compte prudemment un bit d'entropie par relevé au plus ; les relevés ne servent
+    jamais tels quels, ils sont hachés (voir initialisation_aleatoire()).
+    Un nonce de signature prévisible révèle la clé privée : la fonction aléatoire ne doit rien tirer d'une valeur
+    qu'un attaquant peut deviner (compteur de démarrages seul, random() de avr-libc...).  */
+#define NB_RELEVES 64               // À chaque démarrage : environ 1 s
+#define NB_RELEVES_PREMIER 256      // Sans graine dans l'eeprom (premier démarrage) : environ 4 s
+
+volatile uint16_t releve_timer1;
+volatile uint8_t releve_pret = 0;
+
+ISR(WDT_vect) {
+    releve_timer1 = TCNT1;
+    releve_pret = 1;
+}
+
+//  Ajout de 'nombre' relevés au hachage 'contexte' (chien de garde et Timer1 actifs le temps de la collecte)
+void collecte_entropie(sha256_contexte *contexte, uint16_t nombre){
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);       // Timer1 libre, sans prédiviseur
+    cli();
+    WDTCSR = (1 << WDCE) | (1 << WDE);  // Séquence de modification du chien de garde (4 cycles)
+    WDTCSR = (1 << WDIE);               // Interruption seule toutes les 16 ms, sans remise à zéro
+    releve_pret = 0;
+    sei();
+    while(nombre){
+        sleep_mode();       // Réveil par le chien de garde (ou le Timer2, l'UART)
+        cli();
+        uint16_t releve = releve_timer1;
+        uint8_t pret = releve_pret;
+        releve_pret = 0;
+        sei();
+        if(pret){
+            uint8_t octets[2] = {releve, releve >> 8};
+            sha256_ajout(contexte, octets, 2);
+            nombre--;
+        }
+    }
+    cli();
+    WDTCSR = (1 << WDCE) | (1 << WDE);
+    WDTCSR = 0;                 // Chien de garde arrêté
+    sei();
+    TCCR1B = 0;                 // Timer1 arrêté
+}
+
+/*  Fonction aléatoire : HMAC_DRBG (NIST SP 800-90A) avec le HMAC-SHA256 de sha256.c, état (K, V) en SRAM.
+    Au démarrage, l'état est initialisé avec la graine de l'eeprom, le hachage des relevés et le compteur de démarrages
+    (partie 5), écrit avant tout tirage : une coupure de courant ne rejoue aucun tirage, l'état n'est jamais deux fois le
+    même. Tous les PERIODE_GRAINE démarrages, une nouvelle graine est tirée et écrite dans l'eeprom : le secret accumulé
+    au fil des démarrages s'ajoute à l'entropie neuve. Sans graine (eeprom neuve, ou tout à 0x00), tout le secret vient
+    des relevés, d'où une collecte plus longue, et la graine est écrite tout de suite.
+    Après chaque appel de avr_rng(), K et V sont renouvelés : l'état en SRAM ne permet pas de retrouver les tirages déjà
+    faits. Profil CLES_DERIVEES : la clé maître, secrète et tirée par cette même fonction, tient lieu de graine ; elle
+    n'est jamais réécrite ici (voir partie 5 pour la place dans l'eeprom).  */
+#if CLES_DERIVEES
+extern uint8_t cle_maitre_eeprom[];
+#define graine_eeprom cle_maitre_eeprom
+#endif
+
+uint8_t aleatoire_k[SHA256_TAILLE_HASH];
+uint8_t aleatoire_v[SHA256_TAILLE_HASH];
+
+//  V = HMAC(K, V)
+void aleatoire_suivant(){
+    sha256_contexte contexte;
+    hmac_sha256_init(&contexte, aleatoire_k, SHA256_TAILLE_HASH);
+    sha256_ajout(&contexte, aleatoire_v, SHA256_TAILLE_HASH);
+    hmac_sha256_fin(&contexte, aleatoire_k, SHA256_TAILLE_HASH, aleatoire_v);
+}
+
+//  Mise à jour de HMAC_DRBG : K = HMAC(K, V || etape || donnees), V = HMAC(K, V), pour l'étape 0 puis 1 si 'donnees'
+void aleatoire_mise_a_jour(const uint8_t *donnees, uint8_t taille){
+    for(uint8_t etape=0; etape<=(taille > 0); etape++){
+        sha256_contexte contexte;
+        uint8_t cle[SHA256_TAILLE_HASH];
+        hmac_sha256_init(&contexte, aleatoire_k, SHA256_TAILLE_HASH);
+        sha256_ajout(&contexte, aleatoire_v, SHA256_TAILLE_HASH);
+        sha256_ajout(&contexte, &etape, 1);
+        sha256_ajout(&contexte, donnees, taille);
+        hmac_sha256_fin(&contexte, aleatoire_k, SHA256_TAILLE_HASH, cle);
+        memcpy(aleatoire_k, cle, SHA256_TAILLE_HASH);
+        memset(cle, 0, sizeof(cle));
+        aleatoire_suivant();
+    }
+}
+
+void initialisation_aleatoire(){
+    uint8_t graine[TAILLE_GRAINE + SHA256_TAILLE_HASH + 3];   // Graine, hachage des relevés, compteur de démarrages
+    uint8_t ou = 0x00, et = 0xFF, premier;
+    sha256_contexte contexte;
+
+    eeprom_read_block(graine, graine_eeprom, TAILLE_GRAINE);
+    for(uint8_t i=0; i<TAILLE_GRAINE; i++){
+        ou |= graine[i];
+        et &= graine[i];
+    }
+    premier = (ou == 0x00 || et == 0xFF);
+    sha256_init(&contexte);
+    collecte_entropie(&contexte, premier ? NB_RELEVES_PREMIER : NB_RELEVES);
+    sha256_fin(&contexte, &graine[TAILLE_GRAINE]);
+
+    uint32_t compteur = nouveau_demarrage();    // Distinct à chaque démarrage, même si les relevés se répétaient
+    graine[TAILLE_GRAINE + SHA256_TAILLE_HASH] = compteur;
+    graine[TAILLE_GRAINE + SHA256_TAILLE_HASH + 1] = compteur >> 8;
+    graine[TAILLE_GRAINE + SHA256_TAILLE_HASH + 2] = compteur >> 16;
+
+    memset(aleatoire_k, 0x00, SHA256_TAILLE_HASH);
+    memset(aleatoire_v, 0x01, SHA256_TAILLE_HASH);
+    aleatoire_mise_a_jour(graine, sizeof(graine));
+    memset(graine, 0, sizeof(graine));
+
+    #if !CLES_DERIVEES
+    if(premier || compteur % PERIODE_GRAINE == 0){
+        avr_rng(graine, TAILLE_GRAINE);     // Nouvelle graine
+        ecriture_eeprom(graine, graine_eeprom, TAILLE_GRAINE);
+        memset(graine, 0, TAILLE_GRAINE);
+    }
+    #endif
+}
+
 int avr_rng(uint8_t *dest, unsigned size) {
-    for (unsigned i = 0; i < size; i++) {
-        dest[i] = rand() % 256; // Générer un octet pseudo-aléatoire
+    while(size){
+        uint8_t taille = size < SHA256_TAILLE_HASH ? size : SHA256_TAILLE_HASH;
+        aleatoire_suivant();
+        memcpy(dest, aleatoire_v, taille);
+        dest += taille;
+        size -= taille;
     }
+    aleatoire_mise_a_jour(NULL, 0);     // K et V renouvelés : les octets tirés ne peuvent plus être recalculés
     return 1; // Succès
 }
 
+/*  Réserve de nonces (signature en deux temps) : k*G et l'inverse de k, c'est-à-dire presque tout le calcul d'une
+    signature, ne dépendent pas du message. La boucle principale les prépare quand aucune commande n'attend, ni de
+    réception ni de confirmation (remplissage_reserve(), un nonce à la fois), et GET_ASSERTION n'a plus que deux
+    multiplications modulo n à faire.
+    La réserve est en SRAM : elle disparaît à la coupure de courant, un nonce ne peut donc pas resservir après un
+    redémarrage (l'état de la fonction aléatoire change à chaque démarrage, voir initialisation_aleatoire()).  */
+#define TAILLE_RESERVE 4    // 4 x 41 octets de SRAM
+
+uECC_Nonce reserve_nonces[TAILLE_RESERVE];
+uint8_t reserve_compteur = 0;   // Nombre de nonces prêts (les premiers de reserve_nonces)
+
+//  Préparation d'un nonce si la réserve n'est pas pleine
+void remplissage_reserve(){
+    if(reserve_compteur < TAILLE_RESERVE && uECC_make_nonce(&reserve_nonces[reserve_compteur])){
+        reserve_compteur++;
+    }
+}
+
+/*  Signature avec le dernier nonce de la réserve, ou avec uECC_sign() si la réserve est vide. Le nonce est retiré et
+    effacé de la réserve avant de signer : même si la signature échoue, il ne sert qu'une fois. Sa copie locale (k et
+    1/k) est aussi effacée de la pile après la signature.  */
+uint8_t signature_reserve(const uint8_t *private_key, const uint8_t *hash, uint8_t *signature){
+    uECC_Nonce nonce;
+    uint8_t resultat = 0;
+    if(reserve_compteur > 0){
+        reserve_compteur--;
+        nonce = reserve_nonces[reserve_compteur];
+        memset(&reserve_nonces[reserve_compteur], 0, sizeof(uECC_Nonce));
+        resultat = uECC_sign_with_nonce(private_key, hash, &nonce, signature);
+        memset(&nonce, 0, sizeof(nonce));
+        __asm__ volatile("" : : "r"(&nonce) : "memory");   // Effacement gardé par gcc (la copie n'est plus lue)
+    }
+    if(!resultat){
+        resultat = uECC_sign(private_key, hash, signature);     // Réserve vide (ou s hors bornes, cas très rare)
+    }
+    return resultat;
+}
+
+#if CLES_DERIVEES
+/*  Clés dérivées (voir CLES_DERIVEES) : la clé maître de 16 octets est rangée dans l'eeprom et recopiée en SRAM au
+    démarrage. Une eeprom vierge (tout à 0x00 ou tout à 0xFF) déclenche le tirage d'une nouvelle clé.  */
+#define TAILLE_CLE_MAITRE 16
+
+uint8_t EEMEM cle_maitre_eeprom[TAILLE_CLE_MAITRE];
+uint8_t cle_maitre[TAILLE_CLE_MAITRE];
+
+//  Nouvelle clé maître (premier démarrage, RESET) : les clés dérivées de l'ancienne ne peuvent plus être recalculées
+void nouvelle_cle_maitre(){
+    avr_rng(cle_maitre, TAILLE_CLE_MAITRE);
+    ecriture_eeprom(cle_maitre, cle_maitre_eeprom, TAILLE_CLE_MAITRE);
+}
+
+void chargement_cle_maitre(){
+    uint8_t ou = 0x00, et = 0xFF;
+    eeprom_read_block(cle_maitre, cle_maitre_eeprom, TAILLE_CLE_MAITRE);
+    for(int i=0; i<TAILLE_CLE_MAITRE; i++){
+        ou |= cle_maitre[i];
+        et &= cle_maitre[i];
+    }
+    if(ou == 0x00 || et == 0xFF){
+        nouvelle_cle_maitre();
+    }
+}
+
+//  HMAC(clé maître, etiquette || app_id_hash || essai)
+void hmac_application(uint8_t etiquette, const uint8_t *app_id_hash, uint8_t essai, uint8_t *mac){
+    sha256_contexte contexte;
+    hmac_sha256_init(&contexte, cle_maitre, TAILLE_CLE_MAITRE);
+    sha256_ajout(&contexte, &etiquette, 1);
+    sha256_ajout(&contexte, app_id_hash, TAILLE_APP_ID_HASH);
+    sha256_ajout(&contexte, &essai, 1);
+    hmac_sha256_fin(&contexte, cle_maitre, TAILLE_CLE_MAITRE, mac);
+}
+
+/*  Clé privée et credential_id d'une application, sans accès à l'eeprom :
+        credential_id = HMAC(clé maître, 'I' || app_id_hash || 0), tronqué à 16 octets
+        clé privée    = HMAC(clé maître, 'K' || app_id_hash || essai), tronqué à 20 octets
+    Une clé de 160 bits est toujours inférieure à n (161 bits) : seule une clé nulle est refusée, et on recommence
+    alors avec l'essai suivant. Renvoie 0 si aucune clé n'a été trouvée.  */
+uint8_t derivation_cle(const uint8_t *app_id_hash, uint8_t *credential_id, uint8_t *private_key){
+    uint8_t mac[SHA256_TAILLE_HASH];
+    hmac_application('I', app_id_hash, 0, mac);
+    memcpy(credential_id, mac, TAILLE_CREDENTIAL_ID);
+
+    for(uint8_t essai=0; essai<4; essai++){
+        uint8_t non_nulle = 0;
+        hmac_application('K', app_id_hash, essai, mac);
+        memset(private_key, 0, TAILLE_CLE_PRIVE);
+        memcpy(private_key, mac, uECC_BYTES);
+        for(int i=0; i<uECC_BYTES; i++){
+            non_nulle |= mac[i];
+        }
+        memset(mac, 0, sizeof(mac));
+        if(non_nulle){
+            return 1;
+        }
+    }
+    return 0;
+}
+#endif
+
 /*  |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|
     |                                  7. FONCTIONS DE GESTION DES REQUETES RECUES                                   |   
     |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|                                                     
  */
+/*  MAKE_CREDENTIAL, GET_ASSERTION et RESET demandent la confirmation de l'utilisateur et se font en deux temps : la
+    fonction de la commande lit la requête, lance la demande de confirmation et fait les calculs pendant que la LED
+    clignote ; quand l'utilisateur a décidé, la boucle principale appelle fin_requete(), qui envoie la réponse (les
+    calculs ne servent qu'en cas de confirmation). Une seule requête à la fois : les commandes suivantes attendent
+    dans le tampon de réception.  */
+#define AUCUNE_REQUETE 0xFF
+#define LOT_MAX 4   // Signatures par GET_ASSERTIONS : autant que de nonces dans la réserve (voir TAILLE_RESERVE)
+#if 1 + TAILLE_APP_ID_HASH + 1 + LOT_MAX * TAILLE_DATA_HASH > UART_TAILLE_RX - 1
+#error "Une requête GET_ASSERTIONS doit tenir dans le tampon de réception (UART_TAILLE_RX)"
+#endif
+uint8_t requete_en_attente = AUCUNE_REQUETE;    // Commande qui attend la confirmation de l'utilisateur
+
+//  Données de la requête en attente (une seule à la fois)
+union {
+    struct {    // MAKE_CREDENTIAL
+        uint8_t app_id_hash[TAILLE_APP_ID_HASH];
+        uint8_t credential_id[TAILLE_CREDENTIAL_ID];    // Profil 'clés dérivées'
+        uint8_t private_key[TAILLE_CLE_PRIVE];
+        uint8_t public_key[TAILLE_CLE_PUBLIC];
+        uint8_t cle_creee;
+    } creation;
+    struct {    // GET_ASSERTION et GET_ASSERTIONS
+        uint8_t credential_id[TAILLE_CREDENTIAL_ID];
+        uint8_t signatures[LOT_MAX][TAILLE_SIGNATURE];
+        uint8_t nombre;                 // Nombre de signatures demandées (1 pour GET_ASSERTION)
+        uint8_t resultat_recherche;
+        uint8_t resultat_signature;     // Toutes les signatures ont réussi
+    } assertion;
+} donnees_requete;
+
 //  MAKE CREDENTIAL -----------------------
 void make_credential(){
-    uint8_t app_id_hash[TAILLE_APP_ID_HASH];
+    uint8_t *app_id_hash = donnees_requete.creation.app_id_hash;
 
     // Lecture de : app_id_hash = SHA1(app_id)
     for(int i=0; i<TAILLE_APP_ID_HASH; i++){
@@ -297,29 +1264,51 @@ void make_credential(){
     }
 
     // Mode debug pour savoir quel octet on reçoit en premier.
-
-    /* for(int i=0; i<app_id_hash[0]; i++){
+    #if DEBUG_LED
+    for(int i=0; i<app_id_hash[0]; i++){
         PORTD ^= (1 << LED_PIN); // Inverser l'état de la LED
         _delay_ms(500);
         PORTD ^= (1 << LED_PIN); // Inverser l'état de la LED
         _delay_ms(200);
     }
-    _delay_ms(2000); */
+    _delay_ms(2000);
+    #endif
+
+    debut_confirmation_application(app_id_hash);   // Demande de confirmation à user (sauf fenêtre de présence)
+    requete_en_attente = COMMAND_MAKE_CREDENTIAL;
 
-    uint8_t confirmation = demande_confirmation();  // Demande de confirmation à user
+    //  (Tentative de) création d'une paire de clés : (clé privée, clé publique), enregistrée seulement si user confirme
+    PHASE(PHASE_CRYPTO);
+    #if CLES_DERIVEES
+    donnees_requete.creation.cle_creee = derivation_cle(app_id_hash, donnees_requete.creation.credential_id,
+                                                        donnees_requete.creation.private_key)
+                                         && uECC_compute_public_key(donnees_requete.creation.private_key,
+                                                                    donnees_requete.creation.public_key);
+    #else
+    donnees_requete.creation.cle_creee = uECC_make_key(donnees_requete.creation.public_key,
+                                                       donnees_requete.creation.private_key);
+    #endif
+}
+
+void fin_make_credential(uint8_t confirmation){
+    #if !CLES_DERIVEES
+    uint8_t *app_id_hash = donnees_requete.creation.app_id_hash;
+    #endif
 
     // Si il a confirmé ---> On fait le nécessaire
     if(confirmation == 1){
         uint8_t credential_id[TAILLE_CREDENTIAL_ID];
-        uint8_t private_key[TAILLE_CLE_PRIVE];
-        uint8_t public_key[TAILLE_CLE_PUBLIC];
 
-        //  (Tentative de) création d'une paire de clés : (clé privée, clé publique)
-        if (!uECC_make_key(public_key, private_key)){
+        if (!donnees_requete.creation.cle_creee){
             UART__putc(STATUS_ERR_CRYPTO_FAILED);   // Échec de génération de la paire de clés (message erreur)
             return; // Sortie
         }
 
+        #if CLES_DERIVEES
+        //  Clés dérivées : credential_id calculé avec la clé, rien à enregistrer
+        memcpy(credential_id, donnees_requete.creation.credential_id, TAILLE_CREDENTIAL_ID);
+        uint8_t statut_sauvegarde = 1;
+        #else
         /*  La paire de clé a été générée, générons à présent le credential_id
             On a choisi la méthode simple de troncature du app_id_hash
             En étant conscient que ça peut crée des collisions avec d'autres app_id_hash...  */
@@ -328,7 +1317,10 @@ void make_credential(){
         }
 
         //  (Tentative de) Sauvegarde de [app_id_hash, credential, private_key] dans (la suite de) la mémoire EEPROM
-        uint8_t statut_sauvegarde = sauvegarde_entree_eeprom(app_id_hash, credential_id, private_key);
+        PHASE(PHASE_RECHERCHE);
+        uint8_t statut_sauvegarde = sauvegarde_entree_eeprom(app_id_hash, credential_id, donnees_requete.creation.private_key);
+        PHASE(PHASE_REPONSE);
+        #endif
 
         //  Cas de la mémoire pleine ---> code erreur STATUS_ERR_STORAGE_FULL
         if(statut_sauvegarde == 0){
@@ -342,7 +1334,7 @@ void make_credential(){
                 UART__putc(credential_id[i]);
             }
             for(int i=0; i<TAILLE_CLE_PUBLIC; i++){
-                UART__putc(public_key[i]);
+                UART__putc(donnees_requete.creation.public_key[i]);
             }
         }
     }
@@ -353,89 +1345,301 @@ void make_credential(){
 
 //  LIST CREDENTIALS -----------------------
 void list_credentials(){
-    uint8_t compteur = eeprom_read_byte(&compteur_eeprom);  // Nombre de données existantes dans la mémoire
-
-    // Listes temporaires
-    uint8_t octet_lu;
-    uint16_t position_entree_actuelle;
+    #if CLES_DERIVEES
+    uint8_t compteur = 0;   // Clés dérivées : aucune application n'est enregistrée
+    #else
+    uint8_t compteur = nombre_entrees;  // Nombre d'entrées en cours dans le magasin
+    #endif
 
     // Renvoie du message ListCredentialsResponse : [STATUS_OK, count, credential_id, app_id_hash, ... ]
     UART__putc(STATUS_OK); 
     UART__putc(compteur);   
-    for(int i=0; i<compteur; i++){
-        position_entree_actuelle = i*TAILLE_ENTREE; // On commence par le dernier bloc
+    #if !CLES_DERIVEES
+    for(uint8_t e=0; e<MAX_ENTREES; e++){
+        if(!(emplacements_entrees & (1u << e))){
+            continue;   // Emplacement libre ou enregistrement périmé
+        }
 
-        // credential_id
+        // credential_id et app_id_hash = SHA1(app_id), depuis le répertoire en SRAM
         for(int j=0; j<TAILLE_CREDENTIAL_ID; j++){
-            octet_lu = eeprom_read_byte(&donnees_eeprom[position_entree_actuelle + j]);
-            UART__putc(octet_lu); 
+            UART__putc(credential_id_sram[e][j]);
         }
+        for(int j=0; j<TAILLE_APP_ID_HASH; j++){
+            UART__putc(app_id_sram[e][j]);
+        }
+    }
+    #endif
+}
+
+//  LIST CREDENTIALS PAR PAGES -------------
+/*  Liste paginée, message ListPageRequest : [curseur, taille de page, taille du préfixe, préfixe (0 à 20 octets)]
+    Réponse ListPageResponse : [STATUS_OK, count, curseur suivant, credential_id, app_id_hash, ...], avec au plus
+    'taille de page' entrées (ramenée à TAILLE_PAGE_MAX) dont l'app_id_hash commence par le préfixe, prises à partir de
+    l'emplacement 'curseur' (0 pour la première page). Le curseur suivant est l'emplacement de la prochaine entrée qui
+    correspond, ou FIN_LISTE s'il n'y en a plus : le client s'arrête sans requête de trop. Le curseur étant un numéro
+    d'emplacement, une entrée ajoutée ou supprimée entre deux pages ne décale pas les autres. La sélection se fait dans
+    le répertoire en SRAM et une réponse tient en 3 + 8 x 36 octets : la liaison n'est jamais occupée longtemps.  */
+#define TAILLE_PAGE_MAX 8
+#define FIN_LISTE 0xFF
 
-        // app_id_hash = SHA1(app_id)
+void list_page(){
+    uint8_t prefixe[TAILLE_APP_ID_HASH];
+    uint8_t page[TAILLE_PAGE_MAX];     // Emplacements des entrées de la page
+    uint8_t compteur = 0;
+    uint8_t suivant = FIN_LISTE;
+    uint8_t curseur = UART__getc();
+    uint8_t taille_page = UART__getc();
+    uint8_t taille_prefixe = UART__getc();
+
+    for(uint8_t i=0; i<taille_prefixe; i++){
+        uint8_t octet = UART__getc();   // Tout le préfixe annoncé est lu, même trop long : la liaison reste calée
+        if(i < TAILLE_APP_ID_HASH){
+            prefixe[i] = octet;
+        }
+    }
+    if(taille_prefixe > TAILLE_APP_ID_HASH){
+        UART__putc(STATUS_ERR_BAD_PARAMETER);   // Préfixe plus long qu'un app_id_hash (message erreur)
+        return;
+    }
+    if(taille_page == 0){
+        UART__putc(STATUS_ERR_BAD_PARAMETER);   // Page vide (message erreur)
+        return;
+    }
+    if(taille_page > TAILLE_PAGE_MAX){
+        taille_page = TAILLE_PAGE_MAX;
+    }
+
+    PHASE(PHASE_RECHERCHE);
+    for(uint8_t e=curseur; e<MAX_ENTREES && !CLES_DERIVEES; e++){     // Clés dérivées : aucune entrée
+        if(!(emplacements_entrees & (1u << e)) || memcmp(app_id_sram[e], prefixe, taille_prefixe) != 0){
+            continue;   // Emplacement libre, enregistrement périmé ou autre préfixe
+        }
+        if(compteur == taille_page){
+            suivant = e;    // Page pleine : la suivante commence ici
+            break;
+        }
+        page[compteur++] = e;
+    }
+
+    PHASE(PHASE_REPONSE);
+    UART__putc(STATUS_OK);
+    UART__putc(compteur);
+    UART__putc(suivant);
+    for(uint8_t i=0; i<compteur; i++){
+        for(int j=0; j<TAILLE_CREDENTIAL_ID; j++){
+            UART__putc(credential_id_sram[page[i]][j]);
+        }
         for(int j=0; j<TAILLE_APP_ID_HASH; j++){
-            octet_lu = eeprom_read_byte(&donnees_eeprom[position_entree_actuelle + TAILLE_CREDENTIAL_ID + j]);
-            UART__putc(octet_lu); 
+            UART__putc(app_id_sram[page[i]][j]);
         }
     }
 }
 
 //  GET ASSERTION --------------------------
+/*  Recherche de la clé de l'application (ou sa dérivation), puis signature des 'nombre' clientDataHash qui suivent
+    dans la requête, lus au fil de la réception : une seule demande de confirmation, une seule recherche et une seule
+    lecture de la clé privée pour tout le lot. La recherche et les signatures se font pendant la demande de
+    confirmation : quand l'utilisateur appuie, la réponse est prête et part aussitôt. Sans confirmation, le résultat est
+    effacé sans avoir été envoyé.  */
+void assertions(uint8_t *app_id_hash, uint8_t nombre){
+    uint8_t clientDataHash[TAILLE_DATA_HASH];
+    uint8_t private_key[TAILLE_CLE_PRIVE];
+
+    debut_confirmation_application(app_id_hash);   // Demande de confirmation à user (sauf fenêtre de présence)
+    requete_en_attente = COMMAND_GET_ASSERTION;
+    donnees_requete.assertion.nombre = nombre;
+
+    //  Recherche d'une entrée correspondant à app_id_hash = SHA1(app_id) (ou dérivation de sa clé)
+    #if CLES_DERIVEES
+    PHASE(PHASE_CRYPTO);
+    donnees_requete.assertion.resultat_recherche = derivation_cle(app_id_hash, donnees_requete.assertion.credential_id,
+                                                                  private_key);
+    #else
+    PHASE(PHASE_RECHERCHE);
+    donnees_requete.assertion.resultat_recherche = recherche_entree_eeprom(app_id_hash, donnees_requete.assertion.credential_id,
+                                                                           private_key);
+    #endif
+
+    //  Lecture et signature de chaque clientDataHash (lus même sans clé, pour rester synchronisé avec l'ordinateur)
+    donnees_requete.assertion.resultat_signature = donnees_requete.assertion.resultat_recherche;
+    for(uint8_t n=0; n<nombre; n++){
+        PHASE(PHASE_LECTURE);
+        for(int i=0; i<TAILLE_DATA_HASH; i++){
+            clientDataHash[i] = UART__getc(); // Lecture du i-ème caractère reçu
+        }
+        if(donnees_requete.assertion.resultat_signature){
+            PHASE(PHASE_CRYPTO);
+            donnees_requete.assertion.resultat_signature = signature_reserve(private_key, clientDataHash,
+                                                                             donnees_requete.assertion.signatures[n]);
+        }
+    }
+    memset(private_key, 0, sizeof(private_key));
+}
+
 void get_assertion(){
     uint8_t app_id_hash[TAILLE_APP_ID_HASH];
-    // Lecture de SHA1(app_id)
+    // Lecture de SHA1(app_id), puis du clientDataHash par assertions()
     for(int i=0; i<TAILLE_APP_ID_HASH; i++){
         app_id_hash[i] = UART__getc(); // Lecture du i-ème caractère reçu
     }
+    assertions(app_id_hash, 1);
+}
 
-    uint8_t clientDataHash[TAILLE_DATA_HASH];
-    // Lecture de clientDataHash
-    for(int i=0; i<TAILLE_DATA_HASH; i++){
-        clientDataHash[i] = UART__getc(); // Lecture du i-ème caractère reçu
+/*  Signatures en lot, message GetAssertionsRequest : [app_id_hash, nombre, clientDataHash (x nombre)], avec un nombre
+    de 1 à LOT_MAX. Réponse GetAssertionsResponse : [STATUS_OK, credential_id, signature (x nombre)], dans l'ordre des
+    clientDataHash, ou un code erreur comme GET_ASSERTION. Un nombre hors bornes est refusé après lecture de toute la
+    requête.  */
+void get_assertions(){
+    uint8_t app_id_hash[TAILLE_APP_ID_HASH];
+    for(int i=0; i<TAILLE_APP_ID_HASH; i++){
+        app_id_hash[i] = UART__getc();
     }
+    uint8_t nombre = UART__getc();
+    if(nombre == 0 || nombre > LOT_MAX){
+        for(uint16_t i=0; i<(uint16_t)nombre * TAILLE_DATA_HASH; i++){
+            UART__getc();   // clientDataHash ignorés
+        }
+        UART__putc(STATUS_ERR_BAD_PARAMETER);   // Lot vide ou trop grand (message erreur)
+        return;
+    }
+    assertions(app_id_hash, nombre);
+}
 
-    uint8_t confirmation = demande_confirmation();  // Demande de confirmation à user
-
+void fin_get_assertion(uint8_t confirmation){
     if(confirmation == 1){
-        uint8_t credential_id[TAILLE_CREDENTIAL_ID];
-        uint8_t private_key[TAILLE_CLE_PRIVE];
+        if(donnees_requete.assertion.resultat_recherche == 0){
+            UART__putc(STATUS_ERR_NOT_FOUND);   //  Pas de correspondande (message erreur)
+        }
+        // Cas où on n'arrive pas à signer le message
+        else if(!donnees_requete.assertion.resultat_signature){
+            UART__putc(STATUS_ERR_CRYPTO_FAILED);   //  Impossible de signer (message erreur)
+        }
+        // Cas où c'est réussi ---> Envoie de GetAssertionResponse : [STATUS_OK, Credential_id, signature (x nombre)]
+        else{
+            UART__putc(STATUS_OK); 
+            for(int i=0; i<TAILLE_CREDENTIAL_ID; i++){
+                UART__putc(donnees_requete.assertion.credential_id[i]);
+            }
+            for(uint8_t n=0; n<donnees_requete.assertion.nombre; n++){
+                for(int i=0; i<TAILLE_SIGNATURE; i++){
+                    UART__putc(donnees_requete.assertion.signatures[n][i]);
+                }
+            }
+        }
+    }
+    else{
+        UART__putc(STATUS_ERR_APPROVAL);   //  Pas de confirmation du user (message erreur)
+    }
+}
 
-        //  Recherche d'une entrée correspondant à app_id_hash = SHA1(app_id) 
-        uint8_t resultat_recherche = recherche_entree_eeprom(app_id_hash, credential_id, private_key);
+//  SET BAUD --------------------------
+/*  Changement de vitesse de la liaison, message SetBaudRequest : [code] (voir UART__vitesse())
+    1. on répond STATUS_OK à l'ancienne vitesse puis on passe à la nouvelle ;
+    2. l'ordinateur passe aussi à la nouvelle vitesse et envoie l'octet CONFIRMATION_BAUD ;
+    3. si on le reçoit dans les DELAI_CONFIRMATION_BAUD ms, on répond STATUS_OK à la nouvelle vitesse, sinon on revient
+       à 115200 (l'ordinateur, sans réponse, y revient aussi après DELAI_CONFIRMATION_BAUD ms) ;
+    4. ce dernier STATUS_OK peut se perdre : la nouvelle vitesse reste provisoire jusqu'à ce qu'un octet valide arrive
+       (CONFIRMATION_BAUD, que l'ordinateur renvoie dès qu'il a reçu le STATUS_OK, ou une commande). Si rien n'arrive
+       dans les DELAI_CONFIRMATION_BAUD ms, ou si l'octet reçu n'a pas de sens (ordinateur resté à 115200), on revient
+       à 115200 (voir validation_vitesse()).  */
+#define CONFIRMATION_BAUD 0xA5
+#define DELAI_CONFIRMATION_BAUD 500
 
-        if(resultat_recherche == 1){
-            uint8_t signature[TAILLE_SIGNATURE];
+uint8_t vitesse_provisoire = 0;     // Nouvelle vitesse pas encore validée par un octet de l'ordinateur (étape 4)
+uint16_t vitesse_debut;             // Instant du dernier STATUS_OK de set_baud() (millisecondes)
 
-            // Cas où on n'arrive pas à signer le message
-            if (!uECC_sign(private_key, clientDataHash, signature)){
-                UART__putc(STATUS_ERR_CRYPTO_FAILED);   //  Impossible de signer (message erreur)
-                return; // Sortie
-            }
+//  Retour à 115200 : les octets reçus à la mauvaise vitesse sont oubliés
+void retour_vitesse_demarrage(){
+    uint8_t octet;
+    UART__vidage();
+    UART__vitesse(VITESSE_DEMARRAGE);
+    while(UART__lire(&octet));
+    vitesse_provisoire = 0;
+}
 
-            // Cas où c'est réussi ---> Envoie de GetAssertionResponse : [STATUS_OK, Credential_id, signature]
-            UART__putc(STATUS_OK); 
-            for(int i=0; i<TAILLE_CREDENTIAL_ID; i++){
-                UART__putc(credential_id[i]);
-            }
-            for(int i=0; i<TAILLE_SIGNATURE; i++){
-                UART__putc(signature[i]);
+//  Premier octet lu à une vitesse provisoire : renvoie 1 si c'est une commande à traiter, 0 s'il est consommé
+uint8_t validation_vitesse(uint8_t octet){
+    if(octet == CONFIRMATION_BAUD){
+        vitesse_provisoire = 0;     // Dernier accusé de réception de l'ordinateur : vitesse validée
+        return 0;
+    }
+    if(octet <= COMMAND_GET_ASSERTIONS){
+        vitesse_provisoire = 0;     // Commande reçue correctement : l'ordinateur est bien à la nouvelle vitesse
+        return 1;
+    }
+    retour_vitesse_demarrage();     // Octet mal reçu : l'ordinateur est resté (ou revenu) à 115200
+    return 0;
+}
+
+//  Délai de l'étape 4 dépassé sans octet de l'ordinateur
+uint8_t vitesse_expiree(){
+    uint16_t maintenant;
+    if(!vitesse_provisoire){
+        return 0;
+    }
+    cli();
+    maintenant = millisecondes;
+    sei();
+    return (uint16_t)(maintenant - vitesse_debut) >= DELAI_CONFIRMATION_BAUD;
+}
+
+void set_baud(){
+    uint8_t code = UART__getc();
+    if(code >= NB_VITESSES){
+        UART__putc(STATUS_ERR_BAD_PARAMETER);   // Vitesse inconnue (message erreur)
+        return;
+    }
+
+    UART__putc(STATUS_OK);
+    UART__vidage();         // La réponse doit partir entièrement à l'ancienne vitesse
+    UART__vitesse(code);
+
+    uint8_t octet;
+    uint8_t confirmation = 0;
+    for(int i = 0; i < DELAI_CONFIRMATION_BAUD && !confirmation; i++){
+        while(UART__lire(&octet)){      // Les octets reçus pendant le changement de vitesse sont ignorés
+            if(octet == CONFIRMATION_BAUD){
+                confirmation = 1;
             }
         }
-        else if(resultat_recherche == 0){
-            UART__putc(STATUS_ERR_NOT_FOUND);   //  Pas de correspondande (message erreur)
+        if(!confirmation){
+            _delay_ms(1);
         }
     }
+
+    if(confirmation){
+        UART__putc(STATUS_OK);      // Les deux côtés sont à la nouvelle vitesse, si ce STATUS_OK arrive (étape 4)
+        vitesse_provisoire = 1;     // Même vers 115200 : l'ordinateur renvoie CONFIRMATION_BAUD dans tous les cas
+        cli();
+        vitesse_debut = millisecondes;
+        sei();
+    }
     else{
-        UART__putc(STATUS_ERR_APPROVAL);   //  Pas de confirmation du user (message erreur)
+        retour_vitesse_demarrage();     // Échec : retour à 115200
     }
 }
 
 //  RESET -----------------------------
 void command_reset(){
-    uint8_t confirmation = demande_confirmation();  // Demande de confirmation à user
+    #if DUREE_PRESENCE
+    cli();
+    presence_restante = 0;  // Fenêtre de présence fermée : RESET et les commandes suivantes demandent un appui
+    sei();
+    #endif
+    debut_confirmation();   // Demande de confirmation à user
+    requete_en_attente = COMMAND_RESET;
+}
 
+void fin_command_reset(uint8_t confirmation){
     // Si il a confirmé ---> suppression des données
     if(confirmation == 1){
+        PHASE(PHASE_RECHERCHE);
+        #if CLES_DERIVEES
+        nouvelle_cle_maitre();      // Clés dérivées : toutes les clés de l'ancienne clé maître sont perdues
+        #else
         suppression_entrees_eeprom();   
+        #endif
+        PHASE(PHASE_REPONSE);
         UART__putc(STATUS_OK);  // message ResetResponse : [STATUS_OK]
     }
     else{
@@ -443,29 +1647,106 @@ void command_reset(){
     }
 }
 
+//  Réponse à la requête en attente, une fois que l'utilisateur a décidé (1 = confirmé, 0 = refusé ou délai dépassé)
+void fin_requete(uint8_t confirmation){
+    if(requete_en_attente == COMMAND_MAKE_CREDENTIAL){
+        fin_make_credential(confirmation);
+    }
+    else if(requete_en_attente == COMMAND_GET_ASSERTION){
+        fin_get_assertion(confirmation);
+    }
+    else if(requete_en_attente == COMMAND_RESET){
+        fin_command_reset(confirmation);
+    }
+    memset(&donnees_requete, 0, sizeof(donnees_requete));   // Clé privée, signature non envoyée, ...
+    requete_en_attente = AUCUNE_REQUETE;
+}
+
 /*  |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|
     |                                                8. FONCTION MAIN                                                |   
     |----------------------------------------------------------------------------------------------------------------|
     |----------------------------------------------------------------------------------------------------------------|                                                     
  */
-int main() {
-    config();           // Configurations du démarrage
+/*  Un tour de la boucle principale, sans attente : réponse à la requête en attente si l'utilisateur a décidé, sinon
+    lecture d'une nouvelle commande. Quand il n'y a rien à faire, on prépare un nonce de signature (seulement hors des
+    demandes de confirmation : la réserve se remplit une fois la requête terminée), ou on se met en veille jusqu'à la
+    prochaine interruption (octet reçu, ou Timer2 au plus tard une milliseconde après).  */
+void tour_boucle(){
     uint8_t action;     // Permet l'évaluation
-    while(1){
+    if(vitesse_expiree() && !UART__disponible()){
+        retour_vitesse_demarrage();     // Dernier STATUS_OK de SET_BAUD perdu : l'ordinateur est revenu à 115200
+    }
+    if(requete_en_attente != AUCUNE_REQUETE){
+        uint8_t etat = etat_confirmation();
+        if(etat != CONFIRMATION_EN_ATTENTE){
+            PHASE(PHASE_REPONSE);
+            fin_requete(etat == CONFIRMATION_ACCEPTEE);
+            PHASE(PHASE_REPOS);
+            return;
+        }
+    }
+    else if(UART__disponible()){
+        PHASE(PHASE_LECTURE);
         action = UART__getc();  // Lecture de la commande reçue
+        if(vitesse_provisoire && !validation_vitesse(action)){
+            PHASE(PHASE_REPOS);
+            return;
+        }
         if(action == COMMAND_LIST_CREDENTIALS){
+            PHASE(PHASE_REPONSE);   // Répertoire en SRAM envoyé au fil de l'émission
             list_credentials();
         }
+        else if(action == COMMAND_LIST_PAGE){
+            list_page();
+        }
         else if(action == COMMAND_MAKE_CREDENTIAL){
             make_credential();
         }
         else if(action == COMMAND_GET_ASSERTION){
             get_assertion();
         }
+        else if(action == COMMAND_GET_ASSERTIONS){
+            get_assertions();
+        }
         else if(action == COMMAND_RESET){
             command_reset();
         }
+        else if(action == COMMAND_SET_BAUD){
+            set_baud();
+        }
+        else{
+            UART__putc(STATUS_ERR_COMMAND_UNKNOWN);     // Commande inconnue (message erreur)
+        }
+        //  MAKE_CREDENTIAL, GET_ASSERTION et RESET attendent ensuite la décision de l'utilisateur
+        PHASE(requete_en_attente != AUCUNE_REQUETE ? PHASE_CONFIRMATION : PHASE_REPOS);
+        return;
+    }
+
+    /*  Pas de nonce pendant une demande de confirmation : aucune requête en attente n'en a besoin (les signatures de
+        GET_ASSERTION sont faites avant la demande), et un nonce (k*G et une inversion, des centaines de millisecondes
+        sur l'AVR) retarderait d'autant la réponse à l'appui.  */
+    if(reserve_compteur < TAILLE_RESERVE && requete_en_attente == AUCUNE_REQUETE){
+        remplissage_reserve();
+    }
+    #if EFFACEMENT_CLES
+    else if(emplacements_a_effacer){
+        effacement_progressif();
+    }
+    #endif
+    else{
+        cli();
+        if(requete_en_attente != AUCUNE_REQUETE || !UART__disponible()){
+            veille();
+        }
+        sei();
+    }
+}
+
+int main() {
+    config();           // Configurations du démarrage
+    while(1){
+        tour_boucle();
     }
     return 0;
 }
@@ -480,12 +1761,10 @@ int main() {
 /* int main() {
     config();
     while (1) {
-        debounce();             // Appeler la fonction debounce régulièrement
-        if (bouton_appuie) {    // Si un appui validé est détecté
+        if (bouton_appuie) {    // Si un appui validé est détecté (debounce() dans l'interruption du Timer2)
             PORTD ^= (1 << LED_PIN); // Inverser l'état de la LED
             bouton_appuie = 0;   // Réinitialiser le drapeau
         }
-        _delay_ms(15);       // Délai pour limiter la fréquence des vérifications
     }
     return 0;
 } */
\ No newline at end of file
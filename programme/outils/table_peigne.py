@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Génère comb_secp160r1.inc : la table du peigne (méthode de Lim-Lee) utilisée par uECC.c pour calculer k*G.
+
+    T[s][u-1] = 2^(s*E) * (u_0 + u_1*2^(B*E) + u_2*2^(2*B*E) + u_3*2^(3*B*E)) * G    pour u = 1..15
+
+avec DENTS = 4 bits par chiffre, BLOCS = 2 tables et E = 21 colonnes (4 * 2 * 21 = 168 bits >= 161).
+Les points sont écrits en coordonnées affines, dans les deux tailles de mot de uECC (1 et 4 octets).
+
+Le script vérifie aussi les formules complètes (Renes, Costello, Batina 2015, a = -3) telles qu'elles sont
+codées dans uECC.c, en refaisant le calcul du peigne en Python sur quelques scalaires.
+
+Usage : python3 outils/table_peigne.py > comb_secp160r1.inc"""
+import random
+import sys
+
+P = 0xFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF7FFFFFFF
+B = 0x1C97BEFC54BD7A8B65ACF89F81D4D4ADC565FA45
+N = 0x0100000000000000000001F4C8F927AED3CA752257
+G = (0x4A96B5688EF573284664698968C38BB913CBFC82,
+     0x23A628553168947D59DCC912042351377AC5FB32)
+
+DENTS = 4
+BLOCS = 2
+E = 21
+
+
+#   Arithmétique affine de référence
+def addition(p, q):
+    if p is None:
+        return q
+    if q is None:
+        return p
+    if p[0] == q[0]:
+        if (p[1] + q[1]) % P == 0:
+            return None
+        l = (3 * p[0] * p[0] - 3) * pow(2 * p[1], -1, P) % P
+    else:
+        l = (q[1] - p[1]) * pow(q[0] - p[0], -1, P) % P
+    x = (l * l - p[0] - q[0]) % P
+    return (x, (l * (p[0] - x) - p[1]) % P)
+
+
+def multiplication(k, p):
+    r = None
+    for bit in bin(k)[2:]:
+        r = addition(r, r)
+        if bit == '1':
+            r = addition(r, p)
+    return r
+
+
+#   Formules complètes (mêmes étapes que EccPoint_double_complete / EccPoint_add_complete dans uECC.c)
+def doublement_complet(X, Y, Z):
+    t0 = X * X % P
+    t1 = Y * Y % P
+    t2 = Z * Z % P
+    t3 = 2 * X * Y % P
+    Z3 = 2 * X * Z % P
+    Y3 = (B * t2 - Z3) % P
+    Y3 = 3 * Y3 % P
+    X3 = (t1 - Y3) % P
+    Y3 = (t1 + Y3) % P
+    Y3 = X3 * Y3 % P
+    X3 = X3 * t3 % P
+    t2 = 3 * t2 % P
+    Z3 = (B * Z3 - t2 - t0) % P
+    Z3 = 3 * Z3 % P
+    t0 = (3 * t0 - t2) % P
+    t0 = t0 * Z3 % P
+    Y3 = (Y3 + t0) % P
+    t0 = 2 * Y * Z % P
+    Z3 = t0 * Z3 % P
+    X3 = (X3 - Z3) % P
+    Z3 = 4 * t0 * t1 % P
+    return X3, Y3, Z3
+
+
+def addition_complete(X1, Y1, Z1, x2, y2):
+    t0 = X1 * x2 % P
+    t1 = Y1 * y2 % P
+    t3 = (x2 + y2) * (X1 + Y1) % P
+    t3 = (t3 - t0 - t1) % P
+    t4 = (y2 * Z1 + Y1) % P
+    Y3 = (x2 * Z1 + X1) % P
+    X3 = (Y3 - B * Z1) % P
+    X3 = 3 * X3 % P
+    Z3 = (t1 - X3) % P
+    X3 = (t1 + X3) % P
+    t2 = 3 * Z1 % P
+    Y3 = (B * Y3 - t2 - t0) % P
+    Y3 = 3 * Y3 % P
+    t0 = (3 * t0 - t2) % P
+    t1 = t4 * Y3 % P
+    t2 = t0 * Y3 % P
+    Y3 = (X3 * Z3 + t2) % P
+    X3 = (t3 * X3 - t1) % P
+    Z3 = (t4 * Z3 + t3 * t0) % P
+    return X3, Y3, Z3
+
+
+def table():
+    t = []
+    for s in range(BLOCS):
+        base = [multiplication(2 ** (s * E + j * BLOCS * E), G) for j in range(DENTS)]
+        ligne = []
+        for u in range(1, 2 ** DENTS):
+            q = None
+            for j in range(DENTS):
+                if u >> j & 1:
+                    q = addition(q, base[j])
+            ligne.append(q)
+        t.append(ligne)
+    return t
+
+
+def peigne(k, t):
+    X, Y, Z = 0, 1, 0
+    for i in reversed(range(E)):
+        if i != E - 1:
+            X, Y, Z = doublement_complet(X, Y, Z)
+        for s in range(BLOCS):
+            u = sum((k >> (j * BLOCS * E + s * E + i) & 1) << j for j in range(DENTS))
+            q = t[s][(u or 1) - 1]
+            S = addition_complete(X, Y, Z, *q)
+            if u:
+                X, Y, Z = S
+    if Z == 0:
+        return None
+    z = pow(Z, -1, P)
+    return (X * z % P, Y * z % P)
+
+
+def mots(v, taille):
+    nombre = 20 // taille
+    return ['0x%0*X' % (2 * taille, v >> (8 * taille * i) & (2 ** (8 * taille) - 1)) for i in range(nombre)]
+
+
+def ecriture(t, sortie):
+    sortie.write("/* Copyright 2014, Kenneth MacKay. Licensed under the BSD 2-clause license. */\n\n")
+    sortie.write("/* Fixed-base comb table for secp160r1, generated by outils/table_peigne.py (do not edit).\n")
+    sortie.write("   curve_comb[s][u - 1] = 2^(%d*s) * sum(u_j * 2^(%d*j)) * G, in affine coordinates. */\n\n"
+                 % (E, BLOCS * E))
+    for taille, condition in ((1, "#if (uECC_WORD_SIZE == 1)"), (4, "#elif (uECC_WORD_SIZE == 4)")):
+        sortie.write(condition + "\n\n")
+        sortie.write("static const EccPoint curve_comb[uECC_COMB_BLOCKS][(1 << uECC_COMB_TEETH) - 1] "
+                     "uECC_PROGMEM = {\n")
+        par_ligne = 8 if taille == 1 else 5
+        for s, ligne in enumerate(t):
+            sortie.write("    {\n")
+            for u, (x, y) in enumerate(ligne):
+                sortie.write("        { /* u = %d */\n" % (u + 1))
+                for v, fin in ((x, ","), (y, "")):
+                    m = mots(v, taille)
+                    groupes = [", ".join(m[i:i + par_ligne]) for i in range(0, len(m), par_ligne)]
+                    sortie.write("            {" + ",\n             ".join(groupes) + "}" + fin + "\n")
+                sortie.write("        }%s\n" % ("," if u < len(ligne) - 1 else ""))
+            sortie.write("    }%s\n" % ("," if s < len(t) - 1 else ""))
+        sortie.write("};\n\n")
+    sortie.write("#endif /* uECC_WORD_SIZE */\n")
+
+
+if __name__ == '__main__':
+    t = table()
+    aleatoire = random.Random(0)
+    for k in [1, 2, 15, 2 ** 160, N - 1] + [aleatoire.randrange(1, N) for _ in range(20)]:
+        if peigne(k, t) != multiplication(k, G):
+            sys.exit("table_peigne.py : le peigne ne donne pas k*G pour k = %x" % k)
+    ecriture(t, sys.stdout)
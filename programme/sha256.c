@@ -0,0 +1,137 @@
+/*  SHA-256 et HMAC-SHA256 (voir sha256.h).  */
+#include <string.h>
+#include "sha256.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#define lecture_k(i) pgm_read_dword(&k[i])
+#else
+#define PROGMEM
+#define lecture_k(i) (k[i])
+#endif
+
+static const uint32_t k[64] PROGMEM = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTD(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/*  Compression d'un bloc. Les 64 mots du message sont calculés au fur et à mesure dans une fenêtre de 16 mots
+    (64 octets de pile au lieu de 256).  */
+static void sha256_bloc(sha256_contexte *contexte){
+    uint32_t w[16];
+    uint32_t a = contexte->etat[0], b = contexte->etat[1], c = contexte->etat[2], d = contexte->etat[3];
+    uint32_t e = contexte->etat[4], f = contexte->etat[5], g = contexte->etat[6], h = contexte->etat[7];
+
+    for(uint8_t i=0; i<16; i++){
+        w[i] = ((uint32_t)contexte->bloc[4 * i] << 24) | ((uint32_t)contexte->bloc[4 * i + 1] << 16)
+             | ((uint32_t)contexte->bloc[4 * i + 2] << 8) | contexte->bloc[4 * i + 3];
+    }
+    for(uint8_t i=0; i<64; i++){
+        if(i >= 16){
+            uint32_t w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            uint32_t s0 = ROTD(w15, 7) ^ ROTD(w15, 18) ^ (w15 >> 3);
+            uint32_t s1 = ROTD(w2, 17) ^ ROTD(w2, 19) ^ (w2 >> 10);
+            w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+        }
+        uint32_t t1 = h + (ROTD(e, 6) ^ ROTD(e, 11) ^ ROTD(e, 25)) + ((e & f) ^ (~e & g)) + lecture_k(i) + w[i & 15];
+        uint32_t t2 = (ROTD(a, 2) ^ ROTD(a, 13) ^ ROTD(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    contexte->etat[0] += a;
+    contexte->etat[1] += b;
+    contexte->etat[2] += c;
+    contexte->etat[3] += d;
+    contexte->etat[4] += e;
+    contexte->etat[5] += f;
+    contexte->etat[6] += g;
+    contexte->etat[7] += h;
+}
+
+void sha256_init(sha256_contexte *contexte){
+    contexte->etat[0] = 0x6a09e667;
+    contexte->etat[1] = 0xbb67ae85;
+    contexte->etat[2] = 0x3c6ef372;
+    contexte->etat[3] = 0xa54ff53a;
+    contexte->etat[4] = 0x510e527f;
+    contexte->etat[5] = 0x9b05688c;
+    contexte->etat[6] = 0x1f83d9ab;
+    contexte->etat[7] = 0x5be0cd19;
+    contexte->octets = 0;
+}
+
+void sha256_ajout(sha256_contexte *contexte, const uint8_t *donnees, uint16_t taille){
+    for(uint16_t i=0; i<taille; i++){
+        contexte->bloc[contexte->octets % SHA256_TAILLE_BLOC] = donnees[i];
+        contexte->octets++;
+        if(contexte->octets % SHA256_TAILLE_BLOC == 0){
+            sha256_bloc(contexte);
+        }
+    }
+}
+
+void sha256_fin(sha256_contexte *contexte, uint8_t hash[SHA256_TAILLE_HASH]){
+    uint32_t bits = contexte->octets << 3;      // Messages de moins de 512 Mo
+    uint8_t position = contexte->octets % SHA256_TAILLE_BLOC;
+
+    //  Bourrage : 0x80, des zéros, puis la taille en bits sur 8 octets
+    contexte->bloc[position++] = 0x80;
+    if(position > SHA256_TAILLE_BLOC - 8){
+        memset(contexte->bloc + position, 0, SHA256_TAILLE_BLOC - position);
+        sha256_bloc(contexte);
+        position = 0;
+    }
+    memset(contexte->bloc + position, 0, SHA256_TAILLE_BLOC - 4 - position);
+    contexte->bloc[60] = bits >> 24;
+    contexte->bloc[61] = bits >> 16;
+    contexte->bloc[62] = bits >> 8;
+    contexte->bloc[63] = bits;
+    sha256_bloc(contexte);
+
+    for(uint8_t i=0; i<8; i++){
+        hash[4 * i] = contexte->etat[i] >> 24;
+        hash[4 * i + 1] = contexte->etat[i] >> 16;
+        hash[4 * i + 2] = contexte->etat[i] >> 8;
+        hash[4 * i + 3] = contexte->etat[i];
+    }
+    memset(contexte, 0, sizeof(*contexte));
+}
+
+//  Hachage de la clé complétée par des zéros et combinée avec 'masque' (0x36 : ipad, 0x5c : opad)
+static void hmac_cle(sha256_contexte *contexte, const uint8_t *cle, uint8_t taille_cle, uint8_t masque){
+    uint8_t octet;
+    sha256_init(contexte);
+    for(uint8_t i=0; i<SHA256_TAILLE_BLOC; i++){
+        octet = (i < taille_cle ? cle[i] : 0) ^ masque;
+        sha256_ajout(contexte, &octet, 1);
+    }
+}
+
+void hmac_sha256_init(sha256_contexte *contexte, const uint8_t *cle, uint8_t taille_cle){
+    hmac_cle(contexte, cle, taille_cle, 0x36);
+}
+
+void hmac_sha256_fin(sha256_contexte *contexte, const uint8_t *cle, uint8_t taille_cle,
+                     uint8_t mac[SHA256_TAILLE_HASH]){
+    uint8_t interne[SHA256_TAILLE_HASH];
+    sha256_fin(contexte, interne);
+    hmac_cle(contexte, cle, taille_cle, 0x5c);
+    sha256_ajout(contexte, interne, SHA256_TAILLE_HASH);
+    sha256_fin(contexte, mac);
+    memset(interne, 0, sizeof(interne));
+}
@@ -0,0 +1,27 @@
+/*  SHA-256 (FIPS 180-4) et HMAC-SHA256 (RFC 2104), version compacte pour l'atmega328p : les constantes sont en
+    mémoire flash et le contexte tient en 100 octets de SRAM. Utilisé par la fonction aléatoire et le mode 'clés dérivées' de main.c.  */
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+
+#define SHA256_TAILLE_BLOC 64
+#define SHA256_TAILLE_HASH 32
+
+typedef struct sha256_contexte{
+    uint32_t etat[8];
+    uint8_t bloc[SHA256_TAILLE_BLOC];
+    uint32_t octets;                    // Nombre total d'octets hachés
+} sha256_contexte;
+
+void sha256_init(sha256_contexte *contexte);
+void sha256_ajout(sha256_contexte *contexte, const uint8_t *donnees, uint16_t taille);
+void sha256_fin(sha256_contexte *contexte, uint8_t hash[SHA256_TAILLE_HASH]);
+
+/*  HMAC-SHA256 en trois temps, pour un message en plusieurs morceaux (la clé fait au plus SHA256_TAILLE_BLOC octets).
+    'cle' doit rester accessible jusqu'à hmac_sha256_fin().  */
+void hmac_sha256_init(sha256_contexte *contexte, const uint8_t *cle, uint8_t taille_cle);
+void hmac_sha256_fin(sha256_contexte *contexte, const uint8_t *cle, uint8_t taille_cle,
+                     uint8_t mac[SHA256_TAILLE_HASH]);
+
+#endif
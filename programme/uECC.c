@@ -57,6 +57,16 @@
     #define uECC_WORD_SIZE 4
 #endif
 
+#if (uECC_FIXED_BASE_COMB && (uECC_CURVE != uECC_secp160r1))
+    #undef uECC_FIXED_BASE_COMB
+    #define uECC_FIXED_BASE_COMB 0
+#endif
+
+/* The co-Z ladder is only needed for k*G when the comb is disabled. */
+#ifndef uECC_LADDER
+    #define uECC_LADDER (!uECC_FIXED_BASE_COMB)
+#endif
+
 #if __STDC_VERSION__ >= 199901L
     #define RESTRICT restrict
 #else
@@ -480,6 +490,12 @@ void uECC_set_rng(uECC_RNG_Function rng_function) {
                       uECC_PLATFORM == uECC_arm_thumb2))
         #include "asm_arm.inc"
     #endif
+
+    /* secp160r1 and secp224r1 use 32-bit words (uECC_x86) on x86_64 too */
+    #if (uECC_ASM && defined(__x86_64__) && (uECC_WORD_SIZE != 1) && \
+         (uECC_PLATFORM == uECC_x86 || uECC_PLATFORM == uECC_x86_64))
+        #include "asm_x86_64.inc"
+    #endif
 #endif
 
 #if !asm_clear
@@ -1465,10 +1481,56 @@ static void vli_modSquare_fast(uECC_word_t *result, const uECC_word_t *left) {
 
 
 #define EVEN(vli) (!(vli[0] & 1))
+#if !asm_modInv
+#if (uECC_CURVE == uECC_secp160r1) && uECC_CONST_TIME_INV
+
+/* x = x^(2^squarings) * factor */
+static void vli_modSquareMult_fast(uECC_word_t *x, uint8_t squarings, const uECC_word_t *factor) {
+    while (squarings--) {
+        vli_modSquare_fast(x, x);
+    }
+    vli_modMult_fast(x, x, factor);
+}
+
+/* Computes result = (1 / input) % p as input^(p - 2) (Fermat's little theorem). mod must be curve_p.
+   The addition chain (159 squarings, 12 multiplications) is the same for every input, so the running
+   time does not depend on it. p - 2 = 2^160 - 2^31 - 3 is, from the top, 128 ones, a zero, 29 ones, a
+   zero and a one; with xk = input^(2^k - 1), the result is (x128^(2^30) * x29)^(2^2) * input. */
+static void vli_modInv(uECC_word_t *result, const uECC_word_t *input, const uECC_word_t *mod) {
+    uECC_word_t x2[uECC_WORDS];
+    uECC_word_t x3[uECC_WORDS];
+    uECC_word_t x29[uECC_WORDS];
+    uECC_word_t t[uECC_WORDS];
+    uECC_word_t u[uECC_WORDS];
+    (void)mod;
+
+    vli_set(x2, input);
+    vli_modSquareMult_fast(x2, 1, input); /* x2 */
+    vli_set(x3, x2);
+    vli_modSquareMult_fast(x3, 1, input); /* x3 */
+    vli_set(t, x3);
+    vli_modSquareMult_fast(t, 3, x3);     /* x6 */
+    vli_set(u, t);
+    vli_modSquareMult_fast(u, 6, t);      /* x12 */
+    vli_set(t, u);
+    vli_modSquareMult_fast(t, 12, u);     /* x24 */
+    vli_modSquareMult_fast(t, 3, x3);     /* x27 */
+    vli_modSquareMult_fast(t, 2, x2);     /* x29 */
+    vli_set(x29, t);
+    vli_modSquareMult_fast(t, 3, x3);     /* x32 */
+    vli_set(u, t);
+    vli_modSquareMult_fast(u, 32, t);     /* x64 */
+    vli_set(t, u);
+    vli_modSquareMult_fast(t, 64, u);     /* x128 */
+    vli_modSquareMult_fast(t, 30, x29);   /* 128 ones, a zero, 29 ones */
+    vli_modSquareMult_fast(t, 2, input);  /* p - 2 */
+    vli_set(result, t);
+}
+
+#else
 /* Computes result = (1 / input) % mod. All VLIs are the same size.
    See "From Euclid's GCD to Montgomery Multiplication to the Great Divide"
    https://labs.oracle.com/techrep/2001/smli_tr-2001-95.pdf */
-#if !asm_modInv
 static void vli_modInv(uECC_word_t *result, const uECC_word_t *input, const uECC_word_t *mod) {
     uECC_word_t a[uECC_WORDS], b[uECC_WORDS], u[uECC_WORDS], v[uECC_WORDS];
     uECC_word_t carry;
@@ -1536,6 +1598,7 @@ static void vli_modInv(uECC_word_t *result, const uECC_word_t *input, const uECC
     }
     vli_set(result, u);
 }
+#endif /* uECC_CONST_TIME_INV */
 #endif /* !asm_modInv */
 
 /* ------ Point operations ------ */
@@ -1545,11 +1608,9 @@ static cmpresult_t EccPoint_isZero(const EccPoint *point) {
     return (vli_isZero(point->x) && vli_isZero(point->y));
 }
 
-/* Point multiplication algorithm using Montgomery's ladder with co-Z coordinates.
-From http://eprint.iacr.org/2011/338.pdf
-*/
+#if uECC_LADDER || uECC_VERIFY || uECC_MULT_BATCH
 
-/* Double in place */
+/* Double in place, in Jacobian coordinates (used by the ladder and by uECC_verify()) */
 #if (uECC_CURVE == uECC_secp256k1)
 static void EccPoint_double_jacobian(uECC_word_t * RESTRICT X1,
                                      uECC_word_t * RESTRICT Y1,
@@ -1634,6 +1695,14 @@ static void EccPoint_double_jacobian(uECC_word_t * RESTRICT X1,
 }
 #endif
 
+#endif /* uECC_LADDER || uECC_VERIFY || uECC_MULT_BATCH */
+
+#if uECC_LADDER || uECC_MULT_BATCH
+
+/* Point multiplication algorithm using Montgomery's ladder with co-Z coordinates.
+From http://eprint.iacr.org/2011/338.pdf
+*/
+
 /* Modify (x1, y1) => (x1 * z^2, y1 * z^3) */
 static void apply_z(uECC_word_t * RESTRICT X1,
                     uECC_word_t * RESTRICT Y1,
@@ -1736,6 +1805,10 @@ static void XYcZ_addC(uECC_word_t * RESTRICT X1,
     vli_set(X1, t7);
 }
 
+#endif /* uECC_LADDER || uECC_MULT_BATCH */
+
+#if uECC_LADDER
+
 static void EccPoint_mult(EccPoint * RESTRICT result,
                           const EccPoint * RESTRICT point,
                           const uECC_word_t * RESTRICT scalar,
@@ -1778,18 +1851,244 @@ static void EccPoint_mult(EccPoint * RESTRICT result,
     vli_set(result->y, Ry[0]);
 }
 
+#endif /* uECC_LADDER */
+
+#if uECC_FIXED_BASE_COMB
+
+/* Fixed-base point multiplication k*G with a Lim-Lee comb. The scalar bits are read in columns:
+   column i of block s gives the index u = sum(bit(i + s*SPACING + j*BLOCKS*SPACING) << j), and
+   curve_comb[s][u - 1] holds the matching sum of multiples of G. All the blocks share the same
+   doublings, so k*G costs SPACING - 1 doublings and BLOCKS * SPACING additions.
+
+   The point operations are the complete formulas for a = -3 from http://eprint.iacr.org/2015/1060.pdf
+   (Algorithms 5 and 6), in projective coordinates. They are valid for all inputs, including the point
+   at infinity (0 : 1 : 0), so every column costs the same whatever the scalar: a zero index adds a
+   dummy entry whose result is discarded, and the table is always scanned in full. */
+#define uECC_COMB_TEETH 4
+#define uECC_COMB_BLOCKS 2
+#define uECC_COMB_SPACING 21 /* 4 * 2 * 21 = 168 bits, more than the 161 bits of curve_n */
+
+#if (uECC_PLATFORM == uECC_avr)
+    #include <avr/pgmspace.h>
+    #define uECC_PROGMEM PROGMEM
+    #if (uECC_WORD_SIZE == 1)
+        #define comb_read_word(p) pgm_read_byte(p)
+    #else
+        #define comb_read_word(p) pgm_read_dword(p)
+    #endif
+#else
+    #define uECC_PROGMEM
+    #define comb_read_word(p) (*(p))
+#endif
+
+#include "comb_secp160r1.inc"
+
+/* Double in place: (X1, Y1, Z1) => 2 * (X1, Y1, Z1). */
+static void EccPoint_double_complete(uECC_word_t * RESTRICT X1,
+                                     uECC_word_t * RESTRICT Y1,
+                                     uECC_word_t * RESTRICT Z1) {
+    uECC_word_t t0[uECC_WORDS];
+    uECC_word_t t1[uECC_WORDS];
+    uECC_word_t t2[uECC_WORDS];
+    uECC_word_t t3[uECC_WORDS];
+    uECC_word_t t4[uECC_WORDS];
+
+    vli_modMult_fast(t4, Y1, Z1);     /* t4 = y1*z1 */
+    vli_modAdd(t4, t4, t4, curve_p);  /* t4 = 2*y1*z1 */
+    vli_modSquare_fast(t0, X1);       /* t0 = x1^2 */
+    vli_modSquare_fast(t1, Y1);       /* t1 = y1^2 */
+    vli_modSquare_fast(t2, Z1);       /* t2 = z1^2 */
+    vli_modMult_fast(t3, X1, Y1);     /* t3 = x1*y1 */
+    vli_modAdd(t3, t3, t3, curve_p);  /* t3 = 2*x1*y1 */
+    vli_modMult_fast(Z1, X1, Z1);     /* z3 = x1*z1 */
+    vli_modAdd(Z1, Z1, Z1, curve_p);  /* z3 = 2*x1*z1 */
+
+    vli_modMult_fast(Y1, curve_b, t2); /* y3 = b*z1^2 */
+    vli_modSub_fast(Y1, Y1, Z1);       /* y3 = b*z1^2 - z3 */
+    vli_modAdd(X1, Y1, Y1, curve_p);   /* x3 = 2*y3 */
+    vli_modAdd(Y1, X1, Y1, curve_p);   /* y3 = 3*y3 */
+    vli_modSub_fast(X1, t1, Y1);       /* x3 = y1^2 - y3 */
+    vli_modAdd(Y1, t1, Y1, curve_p);   /* y3 = y1^2 + y3 */
+    vli_modMult_fast(Y1, X1, Y1);      /* y3 = x3*y3 */
+    vli_modMult_fast(X1, X1, t3);      /* x3 = x3*t3 */
+
+    vli_modAdd(t3, t2, t2, curve_p);  /* t3 = 2*z1^2 */
+    vli_modAdd(t2, t2, t3, curve_p);  /* t2 = 3*z1^2 */
+    vli_modMult_fast(Z1, curve_b, Z1); /* z3 = b*z3 */
+    vli_modSub_fast(Z1, Z1, t2);      /* z3 = z3 - t2 */
+    vli_modSub_fast(Z1, Z1, t0);      /* z3 = z3 - t0 */
+    vli_modAdd(t3, Z1, Z1, curve_p);  /* t3 = 2*z3 */
+    vli_modAdd(Z1, Z1, t3, curve_p);  /* z3 = 3*z3 */
+    vli_modAdd(t3, t0, t0, curve_p);  /* t3 = 2*t0 */
+    vli_modAdd(t0, t3, t0, curve_p);  /* t0 = 3*t0 */
+    vli_modSub_fast(t0, t0, t2);      /* t0 = t0 - t2 */
+    vli_modMult_fast(t0, t0, Z1);     /* t0 = t0*z3 */
+    vli_modAdd(Y1, Y1, t0, curve_p);  /* y3 = y3 + t0 */
+
+    vli_modMult_fast(Z1, t4, Z1);     /* z3 = t4*z3 */
+    vli_modSub_fast(X1, X1, Z1);      /* x3 = x3 - z3 */
+    vli_modMult_fast(Z1, t4, t1);     /* z3 = 2*y1*z1 * y1^2 */
+    vli_modAdd(Z1, Z1, Z1, curve_p);
+    vli_modAdd(Z1, Z1, Z1, curve_p);  /* z3 = 8*y1^3*z1 */
+}
+
+/* Add in place: (X1, Y1, Z1) => (X1, Y1, Z1) + (x2, y2), where (x2, y2) is affine (not infinity). */
+static void EccPoint_add_complete(uECC_word_t * RESTRICT X1,
+                                  uECC_word_t * RESTRICT Y1,
+                                  uECC_word_t * RESTRICT Z1,
+                                  const uECC_word_t * RESTRICT x2,
+                                  const uECC_word_t * RESTRICT y2) {
+    uECC_word_t t0[uECC_WORDS];
+    uECC_word_t t1[uECC_WORDS];
+    uECC_word_t t2[uECC_WORDS];
+    uECC_word_t t3[uECC_WORDS];
+    uECC_word_t t4[uECC_WORDS];
+
+    vli_modMult_fast(t0, X1, x2);     /* t0 = x1*x2 */
+    vli_modMult_fast(t1, Y1, y2);     /* t1 = y1*y2 */
+    vli_modAdd(t3, x2, y2, curve_p);  /* t3 = x2 + y2 */
+    vli_modAdd(t4, X1, Y1, curve_p);  /* t4 = x1 + y1 */
+    vli_modMult_fast(t3, t3, t4);     /* t3 = (x2 + y2)*(x1 + y1) */
+    vli_modAdd(t4, t0, t1, curve_p);  /* t4 = t0 + t1 */
+    vli_modSub_fast(t3, t3, t4);      /* t3 = x1*y2 + x2*y1 */
+    vli_modMult_fast(t4, y2, Z1);     /* t4 = y2*z1 */
+    vli_modAdd(t4, t4, Y1, curve_p);  /* t4 = y2*z1 + y1 */
+    vli_modMult_fast(Y1, x2, Z1);     /* y3 = x2*z1 */
+    vli_modAdd(Y1, Y1, X1, curve_p);  /* y3 = x2*z1 + x1 */
+    vli_modAdd(t2, Z1, Z1, curve_p);  /* t2 = 2*z1 */
+    vli_modAdd(t2, t2, Z1, curve_p);  /* t2 = 3*z1 */
+
+    vli_modMult_fast(Z1, curve_b, Z1); /* z3 = b*z1 */
+    vli_modSub_fast(X1, Y1, Z1);       /* x3 = y3 - z3 */
+    vli_modAdd(Z1, X1, X1, curve_p);   /* z3 = 2*x3 */
+    vli_modAdd(X1, X1, Z1, curve_p);   /* x3 = 3*x3 */
+    vli_modSub_fast(Z1, t1, X1);       /* z3 = t1 - x3 */
+    vli_modAdd(X1, t1, X1, curve_p);   /* x3 = t1 + x3 */
+    vli_modMult_fast(Y1, curve_b, Y1); /* y3 = b*y3 */
+    vli_modSub_fast(Y1, Y1, t2);       /* y3 = y3 - t2 */
+    vli_modSub_fast(Y1, Y1, t0);       /* y3 = y3 - t0 */
+    vli_modAdd(t1, Y1, Y1, curve_p);   /* t1 = 2*y3 */
+    vli_modAdd(Y1, t1, Y1, curve_p);   /* y3 = 3*y3 */
+    vli_modAdd(t1, t0, t0, curve_p);   /* t1 = 2*t0 */
+    vli_modAdd(t0, t1, t0, curve_p);   /* t0 = 3*t0 */
+    vli_modSub_fast(t0, t0, t2);       /* t0 = t0 - t2 */
+
+    vli_modMult_fast(t1, t4, Y1);     /* t1 = t4*y3 */
+    vli_modMult_fast(t2, t0, Y1);     /* t2 = t0*y3 */
+    vli_modMult_fast(Y1, X1, Z1);     /* y3 = x3*z3 */
+    vli_modAdd(Y1, Y1, t2, curve_p);  /* y3 = y3 + t2 */
+    vli_modMult_fast(X1, t3, X1);     /* x3 = t3*x3 */
+    vli_modSub_fast(X1, X1, t1);      /* x3 = x3 - t1 */
+    vli_modMult_fast(Z1, t4, Z1);     /* z3 = t4*z3 */
+    vli_modMult_fast(t1, t3, t0);     /* t1 = t3*t0 */
+    vli_modAdd(Z1, Z1, t1, curve_p);  /* z3 = z3 + t1 */
+}
+
+/* Returns the comb index of column 'bit' (the lowest bit of the column). */
+static uint8_t comb_index(const uECC_word_t *scalar, bitcount_t bit) {
+    uint8_t index = 0;
+    uint8_t j;
+    for (j = 0; j < uECC_COMB_TEETH; ++j) {
+        index |= ((scalar[bit >> uECC_WORD_BITS_SHIFT] >> (bit & uECC_WORD_BITS_MASK)) & 1) << j;
+        bit += uECC_COMB_BLOCKS * uECC_COMB_SPACING;
+    }
+    return index;
+}
+
+/* Loads curve_comb[block][index - 1] into 'point'. Every entry of the block is read, so the memory
+   accesses do not depend on 'index'. */
+static void comb_select(EccPoint *point, uint8_t block, uint8_t index) {
+    const EccPoint *entry = curve_comb[block];
+    uECC_word_t mask;
+    wordcount_t i;
+    uint8_t u;
+
+    vli_clear(point->x);
+    vli_clear(point->y);
+    for (u = 1; u < (1 << uECC_COMB_TEETH); ++u, ++entry) {
+        /* All ones if u == index, 0 otherwise */
+        mask = (uECC_word_t)0 - (uECC_word_t)((uint16_t)((u ^ index) - 1) >> 15);
+        for (i = 0; i < uECC_WORDS; ++i) {
+            point->x[i] |= comb_read_word(&entry->x[i]) & mask;
+            point->y[i] |= comb_read_word(&entry->y[i]) & mask;
+        }
+    }
+}
+
+/* dest = src if 'keep' is 0, unchanged if 'keep' is 1 (without branching on 'keep'). */
+static void vli_select(uECC_word_t *dest, const uECC_word_t *src, uint8_t keep) {
+    uECC_word_t mask = (uECC_word_t)keep - 1;
+    wordcount_t i;
+    for (i = 0; i < uECC_WORDS; ++i) {
+        dest[i] = (src[i] & mask) | (dest[i] & ~mask);
+    }
+}
+
+/* Computes result = scalar * G. 'scalar' has uECC_N_WORDS words (at least 168 bits). The point at
+   infinity is returned as (0, 0). */
+static void EccPoint_mult_comb(EccPoint * RESTRICT result, const uECC_word_t * RESTRICT scalar) {
+    uECC_word_t X[uECC_WORDS], Y[uECC_WORDS], Z[uECC_WORDS];
+    uECC_word_t X2[uECC_WORDS], Y2[uECC_WORDS], Z2[uECC_WORDS];
+    EccPoint q;
+    bitcount_t i;
+    uint8_t block;
+    uint8_t index;
+    uint8_t keep;
+
+    /* Start from the point at infinity (0 : 1 : 0) */
+    vli_clear(X);
+    vli_clear(Y);
+    Y[0] = 1;
+    vli_clear(Z);
+
+    for (i = uECC_COMB_SPACING - 1; i >= 0; --i) {
+        if (i != uECC_COMB_SPACING - 1) {
+            EccPoint_double_complete(X, Y, Z);
+        }
+        for (block = 0; block < uECC_COMB_BLOCKS; ++block) {
+            index = comb_index(scalar, block * uECC_COMB_SPACING + i);
+            keep = (uint16_t)(index - 1) >> 15; /* 1 if index == 0 */
+            comb_select(&q, block, index | keep);
+
+            vli_set(X2, X);
+            vli_set(Y2, Y);
+            vli_set(Z2, Z);
+            EccPoint_add_complete(X2, Y2, Z2, q.x, q.y);
+            vli_select(X, X2, keep);
+            vli_select(Y, Y2, keep);
+            vli_select(Z, Z2, keep);
+        }
+    }
+
+    /* Back to affine coordinates (1/0 gives 0, so infinity ends up as (0, 0)). */
+    vli_modInv(Z, Z, curve_p);
+    vli_modMult_fast(result->x, X, Z);
+    vli_modMult_fast(result->y, Y, Z);
+}
+
+#endif /* uECC_FIXED_BASE_COMB */
+
 static int EccPoint_compute_public_key(EccPoint *result, uECC_word_t *private) {
     uECC_word_t tmp1[uECC_WORDS];
     uECC_word_t tmp2[uECC_WORDS];
     uECC_word_t *p2[2] = {tmp1, tmp2};
     uECC_word_t carry;
+#if uECC_FIXED_BASE_COMB
+    uECC_word_t scalar[uECC_N_WORDS];
+#endif
 
     /* Make sure the private key is in the range [1, n-1]. */
     if (vli_isZero(private)) {
         return 0;
     }
 
-#if (uECC_CURVE == uECC_secp160r1)
+#if (uECC_CURVE == uECC_secp160r1) && uECC_FIXED_BASE_COMB
+    // The comb always goes through the same columns, so the leading zeros of the private key
+    // do not show.
+    scalar[uECC_N_WORDS - 1] = 0;
+    vli_set(scalar, private);
+    EccPoint_mult_comb(result, scalar);
+#elif (uECC_CURVE == uECC_secp160r1)
     // Don't regularize the bitcount for secp160r1, since it would have a larger performance
     // impact (about 2% slower on average) and requires the vli_xxx_n functions, leading to
     // a significant increase in code size.
@@ -2028,6 +2327,20 @@ int uECC_make_key(uint8_t public_key[uECC_BYTES*2], uint8_t private_key[uECC_BYT
     return 0;
 }
 
+int uECC_compute_public_key(const uint8_t private_key[uECC_BYTES],
+                            uint8_t public_key[uECC_BYTES * 2]) {
+    uECC_word_t private[uECC_WORDS];
+    EccPoint public;
+
+    vli_bytesToNative(private, private_key);
+    if (!EccPoint_compute_public_key(&public, private)) {
+        return 0;
+    }
+    vli_nativeToBytes(public_key, public.x);
+    vli_nativeToBytes(public_key + uECC_BYTES, public.y);
+    return 1;
+}
+
 int uECC_bytes(void) {
     return uECC_BYTES;
 }
@@ -2095,6 +2408,7 @@ static uECC_word_t vli_sub_n(uECC_word_t *result,
     return borrow;
 }
 
+#if !asm_mult_n
 #if !muladd_exists
 static void muladd(uECC_word_t a,
                    uECC_word_t b,
@@ -2130,6 +2444,7 @@ static void vli_mult_n(uECC_word_t *result, const uECC_word_t *left, const uECC_
     }
     result[uECC_N_WORDS * 2 - 1] = r0;
 }
+#endif /* !asm_mult_n */
 
 static void vli_modAdd_n(uECC_word_t *result,
                          const uECC_word_t *left,
@@ -2141,6 +2456,7 @@ static void vli_modAdd_n(uECC_word_t *result,
     }
 }
 
+#if !uECC_CONST_TIME_INV
 static void vli_modInv_n(uECC_word_t *result, const uECC_word_t *input, const uECC_word_t *mod) {
     uECC_word_t a[uECC_N_WORDS], b[uECC_N_WORDS], u[uECC_N_WORDS], v[uECC_N_WORDS];
     uECC_word_t carry;
@@ -2208,57 +2524,104 @@ static void vli_modInv_n(uECC_word_t *result, const uECC_word_t *input, const uE
     }
     vli_set_n(result, u);
 }
+#endif /* !uECC_CONST_TIME_INV */
 
-static void vli2_rshift1_n(uECC_word_t *vli) {
-    vli_rshift1_n(vli);
-    vli[uECC_N_WORDS - 1] |= vli[uECC_N_WORDS] << (uECC_WORD_BITS - 1);
-    vli_rshift1_n(vli + uECC_N_WORDS);
-}
-
-static uECC_word_t vli2_sub_n(uECC_word_t *result,
-                              const uECC_word_t *left,
-                              const uECC_word_t *right) {
-    uECC_word_t borrow = 0;
-    wordcount_t i;
-    for (i = 0; i < uECC_N_WORDS * 2; ++i) {
-        uECC_word_t diff = left[i] - right[i] - borrow;
-        if (diff != left[i]) {
-            borrow = (diff > left[i]);
-        }
-        result[i] = diff;
-    }
-    return borrow;
-}
+/* Barrett constant for curve_n: mu = floor(2^322 / n), where 161 is the bit length of n. */
+#if (uECC_WORD_SIZE == 1)
+static const uECC_word_t curve_barrett_n[uECC_N_WORDS] = {
+    0xB3, 0x76, 0x2B, 0xD6, 0xB0, 0x44, 0x61, 0x1B,
+    0xDC, 0x2C, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0x03};
+#elif (uECC_WORD_SIZE == 4)
+static const uECC_word_t curve_barrett_n[uECC_N_WORDS] = {
+    0xD62B76B3, 0x1B6144B0, 0xFFF82CDC, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000003};
+#endif
 
-/* Computes result = (left * right) % curve_n. */
+/* Computes result = (left * right) % curve_n, with a Barrett reduction (Handbook of Applied
+   Cryptography, Algorithm 14.42, counted in bits rather than words). For x = left * right < 2^322,
+   q = floor(floor(x / 2^160) * mu / 2^162) is at most 2 below floor(x / n), so x - q * n < 3n only
+   needs two conditional subtractions. Both of them are always computed. */
 static void vli_modMult_n(uECC_word_t *result, const uECC_word_t *left, const uECC_word_t *right) {
-    bitcount_t i;
     uECC_word_t product[2 * uECC_N_WORDS];
-    uECC_word_t modMultiple[2 * uECC_N_WORDS];
-    uECC_word_t tmp[2 * uECC_N_WORDS];
+    uECC_word_t q[2 * uECC_N_WORDS];
+    uECC_word_t tmp[uECC_N_WORDS];
     uECC_word_t *v[2] = {tmp, product};
     uECC_word_t index = 1;
+    uint8_t i;
 
     vli_mult_n(product, left, right);
-    vli_clear_n(modMultiple);
-    vli_set(modMultiple + uECC_N_WORDS + 1, curve_n);
-    vli_rshift1(modMultiple + uECC_N_WORDS + 1);
-    modMultiple[2 * uECC_N_WORDS - 1] |= HIGH_BIT_SET;
-    modMultiple[uECC_N_WORDS] = HIGH_BIT_SET;
-
-    for (i = 0;
-         i <= ((((bitcount_t)uECC_N_WORDS) << uECC_WORD_BITS_SHIFT) + (uECC_WORD_BITS - 1));
-         ++i) {
-        uECC_word_t borrow = vli2_sub_n(v[1 - index], v[index], modMultiple);
+
+    /* q = floor(floor(x / 2^160) * mu / 2^162) */
+    vli_mult_n(q, product + uECC_WORDS, curve_barrett_n);
+    vli_set_n(tmp, q + uECC_WORDS);
+    vli_rshift1_n(tmp);
+    vli_rshift1_n(tmp);
+
+    /* x - q * n, computed modulo 2^(uECC_N_WORDS * uECC_WORD_BITS) since it is < 3n */
+    vli_mult_n(q, tmp, curve_n);
+    vli_sub_n(product, product, q);
+
+    for (i = 0; i < 2; ++i) {
+        uECC_word_t borrow = vli_sub_n(v[1 - index], v[index], curve_n);
         index = !(index ^ borrow); /* Swap the index if there was no borrow */
-        vli2_rshift1_n(modMultiple);
     }
     vli_set_n(result, v[index]);
 }
 
+#if (uECC_CONST_TIME_INV && !asm_modInv_n)
+/* Computes result = (1 / input) % n as input^(n - 2) (Fermat's little theorem). mod must be curve_n.
+   n - 2 is public: the sliding window (odd powers input^1 to input^15) goes over its 161 bits in the
+   same way for every input, 161 squarings and 25 multiplications. */
+static void vli_modInv_n(uECC_word_t *result, const uECC_word_t *input, const uECC_word_t *mod) {
+    uECC_word_t table[8][uECC_N_WORDS]; /* input^1, input^3, ..., input^15 */
+    uECC_word_t exponent[uECC_N_WORDS];
+    uECC_word_t t[uECC_N_WORDS];
+    bitcount_t i;
+    bitcount_t j;
+    bitcount_t k;
+    uint8_t window;
+    (void)mod;
+
+    vli_set_n(table[0], input);
+    vli_modMult_n(t, input, input);
+    for (window = 1; window < 8; ++window) {
+        vli_modMult_n(table[window], table[window - 1], t);
+    }
+
+    vli_clear_n(exponent);
+    exponent[0] = 2;
+    vli_sub_n(exponent, curve_n, exponent);
+
+    vli_clear_n(t);
+    t[0] = 1;
+    for (i = uECC_BYTES * 8; i >= 0; i = j - 1) {
+        /* Window from bit i down to bit j, at most 4 bits, ending on a one */
+        j = i;
+        if (vli_testBit(exponent, i)) {
+            j = (i >= 3 ? i - 3 : 0);
+            while (!vli_testBit(exponent, j)) {
+                ++j;
+            }
+        }
+        window = 0;
+        for (k = i; k >= j; --k) {
+            vli_modMult_n(t, t, t);
+            window = (window << 1) | !!vli_testBit(exponent, k);
+        }
+        if (window) {
+            vli_modMult_n(t, t, table[window >> 1]);
+        }
+    }
+    vli_set_n(result, t);
+}
+#endif /* (uECC_CONST_TIME_INV && !asm_modInv_n) */
+
 #else
 
 #define vli_cmp_n vli_cmp
+#define vli_isZero_n vli_isZero
+#define vli_clear_n vli_clear
+#define vli_set_n vli_set
 #define vli_modInv_n vli_modInv
 #define vli_modAdd_n vli_modAdd
 
@@ -2305,13 +2668,14 @@ static void vli_modMult_n(uECC_word_t *result, const uECC_word_t *left, const uE
 }
 #endif /* (uECC_CURVE != uECC_secp160r1) */
 
-static int uECC_sign_with_k(const uint8_t private_key[uECC_BYTES],
-                            const uint8_t message_hash[uECC_BYTES],
-                            uECC_word_t k[uECC_N_WORDS],
-                            uint8_t signature[uECC_BYTES*2]) {
+/* Computes the message-independent part of a signature: r = (k * G).x mod n, and replaces k
+   with 1 / k. Returns 0 if k is out of range or r is zero. */
+static int sign_precompute(uECC_word_t k[uECC_N_WORDS], uECC_word_t r[uECC_N_WORDS]) {
     uECC_word_t tmp[uECC_N_WORDS];
+#if !uECC_FIXED_BASE_COMB
     uECC_word_t s[uECC_N_WORDS];
     uECC_word_t *k2[2] = {tmp, s};
+#endif
     EccPoint p;
     uECC_word_t carry;
     uECC_word_t tries;
@@ -2321,7 +2685,11 @@ static int uECC_sign_with_k(const uint8_t private_key[uECC_BYTES],
         return 0;
     }
 
-#if (uECC_CURVE == uECC_secp160r1)
+#if (uECC_CURVE == uECC_secp160r1) && uECC_FIXED_BASE_COMB
+    /* p = k * G. The comb does not depend on the bit length of k, so k does not need to be
+       regularized. */
+    EccPoint_mult_comb(&p, k);
+#elif (uECC_CURVE == uECC_secp160r1)
     /* Make sure that we don't leak timing information about k.
        See http://eprint.iacr.org/2011/232.pdf */
     vli_add_n(tmp, k, curve_n);
@@ -2357,6 +2725,9 @@ static int uECC_sign_with_k(const uint8_t private_key[uECC_BYTES],
         if (!g_rng_function((uint8_t *)tmp, sizeof(tmp))) {
             continue;
         }
+    #if (uECC_CURVE == uECC_secp160r1)
+        tmp[uECC_WORDS] &= 0x01; /* keep rand * k below 2^322 for vli_modMult_n() */
+    #endif
         carry = 1;
         if (!vli_isZero(tmp)) {
             break;
@@ -2373,13 +2744,25 @@ static int uECC_sign_with_k(const uint8_t private_key[uECC_BYTES],
     vli_modInv_n(k, k, curve_n); /* k = 1 / k' */
     vli_modMult_n(k, k, tmp); /* k = 1 / k */
 
-    vli_nativeToBytes(signature, p.x); /* store r */
+    r[uECC_N_WORDS - 1] = 0;
+    vli_set(r, p.x);
+    return 1;
+}
+
+/* Computes s = (e + r*d) / k from r and 1 / k, and stores the signature (r, s). */
+static int sign_finish(const uint8_t private_key[uECC_BYTES],
+                       const uint8_t message_hash[uECC_BYTES],
+                       const uECC_word_t r[uECC_N_WORDS],
+                       const uECC_word_t k[uECC_N_WORDS],
+                       uint8_t signature[uECC_BYTES*2]) {
+    uECC_word_t tmp[uECC_N_WORDS];
+    uECC_word_t s[uECC_N_WORDS];
+
+    vli_nativeToBytes(signature, r); /* store r */
 
     tmp[uECC_N_WORDS - 1] = 0;
     vli_bytesToNative(tmp, private_key); /* tmp = d */
-    s[uECC_N_WORDS - 1] = 0;
-    vli_set(s, p.x);
-    vli_modMult_n(s, tmp, s); /* s = r*d */
+    vli_modMult_n(s, tmp, r); /* s = r*d */
 
     vli_bytesToNative(tmp, message_hash);
     vli_modAdd_n(s, tmp, s, curve_n); /* s = e + r*d */
@@ -2393,6 +2776,18 @@ static int uECC_sign_with_k(const uint8_t private_key[uECC_BYTES],
     return 1;
 }
 
+static int uECC_sign_with_k(const uint8_t private_key[uECC_BYTES],
+                            const uint8_t message_hash[uECC_BYTES],
+                            uECC_word_t k[uECC_N_WORDS],
+                            uint8_t signature[uECC_BYTES*2]) {
+    uECC_word_t r[uECC_N_WORDS];
+
+    if (!sign_precompute(k, r)) {
+        return 0;
+    }
+    return sign_finish(private_key, message_hash, r, k, signature);
+}
+
 int uECC_sign(const uint8_t private_key[uECC_BYTES],
               const uint8_t message_hash[uECC_BYTES],
               uint8_t signature[uECC_BYTES*2]) {
@@ -2412,8 +2807,516 @@ int uECC_sign(const uint8_t private_key[uECC_BYTES],
     return 0;
 }
 
+int uECC_make_nonce(uECC_Nonce *nonce) {
+    uECC_word_t k[uECC_N_WORDS];
+    uECC_word_t r[uECC_N_WORDS];
+    uECC_word_t tries;
+
+    /* Same random draws as uECC_sign(), so that both give the same signature from the same
+       RNG output. */
+    for (tries = 0; tries < MAX_TRIES; ++tries) {
+        if(g_rng_function((uint8_t *)k, sizeof(k))) {
+        #if (uECC_CURVE == uECC_secp160r1)
+            k[uECC_WORDS] &= 0x01;
+        #endif
+            if (sign_precompute(k, r)) {
+                vli_nativeToBytes(nonce->r, r);
+                vli_nativeToBytes(nonce->k_inv + 1, k);
+            #if (uECC_CURVE == uECC_secp160r1)
+                nonce->k_inv[0] = k[uECC_N_WORDS - 1];
+            #else
+                nonce->k_inv[0] = 0;
+            #endif
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int uECC_sign_with_nonce(const uint8_t private_key[uECC_BYTES],
+                         const uint8_t message_hash[uECC_BYTES],
+                         const uECC_Nonce *nonce,
+                         uint8_t signature[uECC_BYTES*2]) {
+    uECC_word_t k[uECC_N_WORDS];
+    uECC_word_t r[uECC_N_WORDS];
+
+    r[uECC_N_WORDS - 1] = 0;
+    vli_bytesToNative(r, nonce->r);
+#if (uECC_CURVE == uECC_secp160r1)
+    k[uECC_N_WORDS - 1] = nonce->k_inv[0];
+#endif
+    vli_bytesToNative(k, nonce->k_inv + 1);
+    if (vli_isZero(r) || vli_isZero_n(k) || vli_cmp_n(curve_n, k) != 1) {
+        return 0;
+    }
+    return sign_finish(private_key, message_hash, r, k, signature);
+}
+
+
+#if uECC_VERIFY || uECC_MULT_BATCH
+
+/* -------- Point validation -------- */
+
+#if (uECC_CURVE == uECC_secp256k1)
+/* Computes result = x^3 + b. result must not overlap x. */
+static void curve_x_side(uECC_word_t * RESTRICT result, const uECC_word_t * RESTRICT x) {
+    vli_modSquare_fast(result, x);                /* r = x^2 */
+    vli_modMult_fast(result, result, x);          /* r = x^3 */
+    vli_modAdd(result, result, curve_b, curve_p); /* r = x^3 + b */
+}
+#else
+/* Computes result = x^3 + ax + b. result must not overlap x. */
+static void curve_x_side(uECC_word_t * RESTRICT result, const uECC_word_t * RESTRICT x) {
+    uECC_word_t _3[uECC_WORDS] = {3}; /* -a = 3 */
+
+    vli_modSquare_fast(result, x);                /* r = x^2 */
+    vli_modSub_fast(result, result, _3);          /* r = x^2 - 3 */
+    vli_modMult_fast(result, result, x);          /* r = x^3 - 3x */
+    vli_modAdd(result, result, curve_b, curve_p); /* r = x^3 - 3x + b */
+}
+#endif
+
+static int EccPoint_isValid(const EccPoint *point) {
+    uECC_word_t tmp1[uECC_WORDS];
+    uECC_word_t tmp2[uECC_WORDS];
+
+    /* The point at infinity is invalid. */
+    if (EccPoint_isZero(point)) {
+        return 0;
+    }
+
+    /* x and y must be smaller than p. */
+    if (vli_cmp(curve_p, point->x) != 1 || vli_cmp(curve_p, point->y) != 1) {
+        return 0;
+    }
+
+    vli_modSquare_fast(tmp1, point->y); /* tmp1 = y^2 */
+    curve_x_side(tmp2, point->x);       /* tmp2 = x^3 + ax + b */
+
+    /* Make sure that y^2 == x^3 + ax + b */
+    return (vli_equal(tmp1, tmp2) != 0);
+}
+
+#endif /* uECC_VERIFY || uECC_MULT_BATCH */
+
+#if uECC_VERIFY
+
+/* -------- ECDSA verification -------- */
+
+int uECC_valid_public_key(const uint8_t public_key[uECC_BYTES*2]) {
+    EccPoint public;
+
+    vli_bytesToNative(public.x, public_key);
+    vli_bytesToNative(public.y, public_key + uECC_BYTES);
+    return EccPoint_isValid(&public);
+}
 
 static bitcount_t smax(bitcount_t a, bitcount_t b) {
     return (a > b ? a : b);
 }
 
+/* Add in place: (X1, Y1, Z1) => (X1, Y1, Z1) + (x2, y2), in Jacobian coordinates, where (x2, y2) is
+   affine (not infinity). Z1 = 0 stands for the point at infinity. Unlike the comb formulas, the
+   special cases (infinity, doubling, opposite points) are branches: verification only handles
+   public values. */
+static void EccPoint_add_jacobian(uECC_word_t * RESTRICT X1,
+                                  uECC_word_t * RESTRICT Y1,
+                                  uECC_word_t * RESTRICT Z1,
+                                  const uECC_word_t * RESTRICT x2,
+                                  const uECC_word_t * RESTRICT y2) {
+    uECC_word_t t1[uECC_WORDS];
+    uECC_word_t t2[uECC_WORDS];
+    uECC_word_t t3[uECC_WORDS];
+    uECC_word_t t4[uECC_WORDS];
+
+    if (vli_isZero(Z1)) {
+        vli_set(X1, x2);
+        vli_set(Y1, y2);
+        vli_clear(Z1);
+        Z1[0] = 1;
+        return;
+    }
+
+    vli_modSquare_fast(t1, Z1);   /* t1 = z1^2 */
+    vli_modMult_fast(t2, x2, t1); /* t2 = x2*z1^2 */
+    vli_modMult_fast(t1, t1, Z1); /* t1 = z1^3 */
+    vli_modMult_fast(t1, t1, y2); /* t1 = y2*z1^3 */
+    vli_modSub_fast(t2, t2, X1);  /* t2 = x2*z1^2 - x1 = H */
+    vli_modSub_fast(t1, t1, Y1);  /* t1 = y2*z1^3 - y1 = R */
+
+    if (vli_isZero(t2)) {
+        if (vli_isZero(t1)) {
+            EccPoint_double_jacobian(X1, Y1, Z1); /* Same point */
+        } else {
+            vli_clear(Z1); /* Opposite points */
+        }
+        return;
+    }
+
+    vli_modMult_fast(Z1, Z1, t2); /* z3 = z1*H */
+    vli_modSquare_fast(t3, t2);   /* t3 = H^2 */
+    vli_modMult_fast(t4, t3, t2); /* t4 = H^3 */
+    vli_modMult_fast(t3, t3, X1); /* t3 = x1*H^2 */
+    vli_modSquare_fast(X1, t1);   /* x3 = R^2 */
+    vli_modSub_fast(X1, X1, t4);  /* x3 = R^2 - H^3 */
+    vli_modSub_fast(X1, X1, t3);
+    vli_modSub_fast(X1, X1, t3);  /* x3 = R^2 - H^3 - 2*x1*H^2 */
+    vli_modSub_fast(t3, t3, X1);  /* t3 = x1*H^2 - x3 */
+    vli_modMult_fast(t3, t3, t1); /* t3 = R*(x1*H^2 - x3) */
+    vli_modMult_fast(t4, t4, Y1); /* t4 = y1*H^3 */
+    vli_modSub_fast(Y1, t3, t4);  /* y3 = R*(x1*H^2 - x3) - y1*H^3 */
+}
+
+/* Converts 'count' points (at most 16) from Jacobian to affine coordinates with a single inversion
+   (Montgomery's trick: the inverse of the product of all the Z gives each 1/Z with 2 more
+   multiplications). Points at infinity (Z = 0) become (0, 0). */
+static void EccPoint_normalize(EccPoint *result,
+                               uECC_word_t (*X)[uECC_WORDS],
+                               uECC_word_t (*Y)[uECC_WORDS],
+                               uECC_word_t (*Z)[uECC_WORDS],
+                               uint8_t count) {
+    uECC_word_t products[16][uECC_WORDS];
+    uECC_word_t inv[uECC_WORDS];
+    uECC_word_t z[uECC_WORDS];
+    uint8_t i;
+
+    /* products[i] = Z[0] * ... * Z[i], leaving out the zeros */
+    vli_clear(inv);
+    inv[0] = 1;
+    for (i = 0; i < count; ++i) {
+        const uECC_word_t *previous = (i ? products[i - 1] : inv);
+        if (vli_isZero(Z[i])) {
+            vli_set(products[i], previous);
+        } else {
+            vli_modMult_fast(products[i], previous, Z[i]);
+        }
+    }
+
+    vli_modInv(inv, products[count - 1], curve_p);
+    for (i = count; i-- > 0; ) {
+        if (vli_isZero(Z[i])) {
+            vli_clear(result[i].x);
+            vli_clear(result[i].y);
+            continue;
+        }
+        if (i) {
+            vli_modMult_fast(z, inv, products[i - 1]); /* z = 1 / Z[i] */
+            vli_modMult_fast(inv, inv, Z[i]);          /* inv = 1 / (Z[0] * ... * Z[i - 1]) */
+        } else {
+            vli_set(z, inv);
+        }
+        vli_modMult_fast(result[i].y, Y[i], z);
+        vli_modSquare_fast(z, z);
+        vli_modMult_fast(result[i].x, X[i], z);          /* x = X / Z^2 */
+        vli_modMult_fast(result[i].y, result[i].y, z); /* y = Y / Z^3 */
+    }
+}
+
+/* Returns the 2 bits of 'vli' at 'bit' and 'bit - 1'. */
+static uint8_t vli_window2(const uECC_word_t *vli, bitcount_t bit) {
+    return (!!vli_testBit(vli, bit) << 1) | !!vli_testBit(vli, bit - 1);
+}
+
+/* u1 * G + u2 * Q is computed at once with Shamir's trick (Straus), reading u1 and u2 two bits at a
+   time. The joint table holds a * G + b * Q for a, b in 0..3 (index a + 4 * b), built with 14
+   additions and brought to affine coordinates with one inversion, so that each window costs 2
+   doublings and at most one mixed addition. */
+int uECC_verify(const uint8_t public_key[uECC_BYTES*2],
+                const uint8_t hash[uECC_BYTES],
+                const uint8_t signature[uECC_BYTES*2]) {
+    uECC_word_t u1[uECC_N_WORDS], u2[uECC_N_WORDS];
+    uECC_word_t z[uECC_N_WORDS];
+    uECC_word_t r[uECC_N_WORDS], s[uECC_N_WORDS];
+    uECC_word_t X[16][uECC_WORDS], Y[16][uECC_WORDS], Z[16][uECC_WORDS];
+    EccPoint table[16];
+    EccPoint public;
+    bitcount_t numBits;
+    bitcount_t i;
+    uint8_t index;
+
+    r[uECC_N_WORDS - 1] = 0;
+    s[uECC_N_WORDS - 1] = 0;
+    vli_bytesToNative(public.x, public_key);
+    vli_bytesToNative(public.y, public_key + uECC_BYTES);
+    vli_bytesToNative(r, signature);
+    vli_bytesToNative(s, signature + uECC_BYTES);
+
+    /* r, s must not be 0. */
+    if (vli_isZero(r) || vli_isZero(s)) {
+        return 0;
+    }
+
+#if (uECC_CURVE != uECC_secp160r1)
+    /* r, s must be < n. */
+    if (vli_cmp(curve_n, r) != 1 || vli_cmp(curve_n, s) != 1) {
+        return 0;
+    }
+#endif
+
+    if (!EccPoint_isValid(&public)) {
+        return 0;
+    }
+
+    /* Calculate u1 and u2. */
+    vli_modInv_n(z, s, curve_n); /* z = 1/s */
+    u1[uECC_N_WORDS - 1] = 0;
+    vli_bytesToNative(u1, hash);
+    vli_modMult_n(u1, u1, z); /* u1 = e/s */
+    vli_modMult_n(u2, r, z);  /* u2 = r/s */
+
+    /* Joint table: G, 2G, 3G, then a * G + b * Q = (a * G + (b - 1) * Q) + Q. */
+    vli_clear(X[0]);
+    vli_clear(Y[0]);
+    vli_clear(Z[0]);
+    vli_set(X[1], curve_G.x);
+    vli_set(Y[1], curve_G.y);
+    vli_clear(Z[1]);
+    Z[1][0] = 1;
+    for (index = 2; index < 16; ++index) {
+        uint8_t previous = (index < 4 ? index - 1 : index - 4);
+        vli_set(X[index], X[previous]);
+        vli_set(Y[index], Y[previous]);
+        vli_set(Z[index], Z[previous]);
+        if (index == 2) {
+            EccPoint_double_jacobian(X[2], Y[2], Z[2]);
+        } else if (index == 3) {
+            EccPoint_add_jacobian(X[3], Y[3], Z[3], curve_G.x, curve_G.y);
+        } else {
+            EccPoint_add_jacobian(X[index], Y[index], Z[index], public.x, public.y);
+        }
+    }
+    EccPoint_normalize(table + 1, X + 1, Y + 1, Z + 1, 15);
+
+    /* From the highest window down; (X[0], Y[0], Z[0]) holds the sum, starting from the point at
+       infinity. */
+    numBits = smax(vli_numBits(u1, uECC_N_WORDS), vli_numBits(u2, uECC_N_WORDS));
+    for (i = (numBits - 1) | 1; i > 0; i -= 2) {
+        EccPoint_double_jacobian(X[0], Y[0], Z[0]);
+        EccPoint_double_jacobian(X[0], Y[0], Z[0]);
+        index = vli_window2(u1, i) | (vli_window2(u2, i) << 2);
+        if (index && !EccPoint_isZero(&table[index])) {
+            EccPoint_add_jacobian(X[0], Y[0], Z[0], table[index].x, table[index].y);
+        }
+    }
+
+    /* The sum must not be the point at infinity. */
+    if (vli_isZero(Z[0])) {
+        return 0;
+    }
+    vli_modInv(z, Z[0], curve_p);
+    vli_modSquare_fast(z, z);
+    vli_modMult_fast(X[0], X[0], z); /* x = X / Z^2 */
+
+    /* v = x (mod n) */
+#if (uECC_CURVE != uECC_secp160r1)
+    if (vli_cmp(curve_n, X[0]) != 1) {
+        vli_sub(X[0], X[0], curve_n);
+    }
+#endif
+
+    /* Accept only if v == r. */
+    return (vli_equal(X[0], r) != 0);
+}
+
+#endif /* uECC_VERIFY */
+
+#if uECC_MULT_BATCH
+
+/* -------- Batched point multiplication -------- */
+
+/* Number of multiplications done together by uECC_mult_batch(), sharing the final inversion of their
+   ladders. A multiple of the number of SIMD lanes (8 or 4). */
+#ifndef uECC_MULT_BATCH_GROUP
+    #define uECC_MULT_BATCH_GROUP 16
+#endif
+
+/* Bit count of the regularized scalars (k + n or k + 2n, as in uECC_sign()) */
+#if (uECC_CURVE == uECC_secp160r1)
+    #define uECC_MULT_BITS ((uECC_BYTES * 8) + 2)
+#else
+    #define uECC_MULT_BITS ((uECC_BYTES * 8) + 1)
+#endif
+
+#if (uECC_CURVE == uECC_secp160r1) && defined(__x86_64__) && defined(__GNUC__)
+    #include "simd_x86_64.inc"
+#endif
+
+/* Replaces each values[i] with 1 / values[i] mod p, with a single inversion (Montgomery's trick).
+   Zero values are left as they are. */
+static void vli_modInv_batch(uECC_word_t (*values)[uECC_WORDS], unsigned count) {
+    uECC_word_t products[uECC_MULT_BATCH_GROUP][uECC_WORDS];
+    uECC_word_t inv[uECC_WORDS];
+    uECC_word_t tmp[uECC_WORDS];
+    unsigned i;
+
+    vli_clear(inv);
+    inv[0] = 1;
+    for (i = 0; i < count; ++i) {
+        const uECC_word_t *previous = (i ? products[i - 1] : inv);
+        if (vli_isZero(values[i])) {
+            vli_set(products[i], previous);
+        } else {
+            vli_modMult_fast(products[i], previous, values[i]);
+        }
+    }
+
+    vli_modInv(inv, products[count - 1], curve_p);
+    for (i = count; i-- > 0; ) {
+        if (vli_isZero(values[i])) {
+            continue;
+        }
+        if (i) {
+            vli_modMult_fast(tmp, inv, products[i - 1]);
+            vli_modMult_fast(inv, inv, values[i]);
+        } else {
+            vli_set(tmp, inv);
+        }
+        vli_set(values[i], tmp);
+    }
+}
+
+/* The loop of EccPoint_mult() (bits uECC_MULT_BITS - 2 down to 0) on 'count' ladders, in SIMD lanes when
+   the processor has them. */
+static void EccPoint_ladder_batch(uECC_word_t (*Rx)[2][uECC_WORDS],
+                                  uECC_word_t (*Ry)[2][uECC_WORDS],
+                                  uECC_word_t (*scalars)[uECC_N_WORDS],
+                                  unsigned count) {
+    bitcount_t i;
+    unsigned item;
+    uECC_word_t nb;
+
+#if simd_ladder
+    if (EccPoint_ladder_simd(Rx, Ry, scalars, count)) {
+        return;
+    }
+#endif
+    for (item = 0; item < count; ++item) {
+        for (i = uECC_MULT_BITS - 2; i > 0; --i) {
+            nb = !vli_testBit(scalars[item], i);
+            XYcZ_addC(Rx[item][1 - nb], Ry[item][1 - nb], Rx[item][nb], Ry[item][nb]);
+            XYcZ_add(Rx[item][nb], Ry[item][nb], Rx[item][1 - nb], Ry[item][1 - nb]);
+        }
+        nb = !vli_testBit(scalars[item], 0);
+        XYcZ_addC(Rx[item][1 - nb], Ry[item][1 - nb], Rx[item][nb], Ry[item][nb]);
+    }
+}
+
+/* Computes count <= uECC_MULT_BATCH_GROUP products and returns the number of valid items. Each item goes
+   through the steps of EccPoint_mult(), the ladders side by side; the final 1/Z values share one inversion.
+   An invalid item runs the ladder of 2 * G and gets a zero result. The ladder cannot compute 1 * P and
+   (n - 1) * P, which go through the point at infinity: those results are set to P and -P at the end. */
+static unsigned mult_group(const uint8_t *public_keys,
+                           const uint8_t *scalars,
+                           uint8_t *results,
+                           unsigned count) {
+    EccPoint point[uECC_MULT_BATCH_GROUP];
+    uECC_word_t k[uECC_MULT_BATCH_GROUP][uECC_N_WORDS];
+    uECC_word_t Rx[uECC_MULT_BATCH_GROUP][2][uECC_WORDS];
+    uECC_word_t Ry[uECC_MULT_BATCH_GROUP][2][uECC_WORDS];
+    uECC_word_t z[uECC_MULT_BATCH_GROUP][uECC_WORDS];
+    uECC_word_t tmp1[uECC_N_WORDS];
+    uECC_word_t tmp2[uECC_N_WORDS];
+    uECC_word_t *k2[2] = {tmp1, tmp2};
+    uECC_word_t carry;
+    uECC_word_t nb;
+    uint8_t valid[uECC_MULT_BATCH_GROUP];
+    uint8_t special[uECC_MULT_BATCH_GROUP]; /* 1 for k = 1, 2 for k = n - 1 */
+    unsigned item;
+    unsigned total = 0;
+
+    for (item = 0; item < count; ++item) {
+        k[item][uECC_N_WORDS - 1] = 0;
+        vli_bytesToNative(point[item].x, public_keys + item * uECC_BYTES * 2);
+        vli_bytesToNative(point[item].y, public_keys + item * uECC_BYTES * 2 + uECC_BYTES);
+        vli_bytesToNative(k[item], scalars + item * uECC_BYTES);
+
+        /* 0 < k < n, and the point must be on the curve. */
+        valid[item] = !vli_isZero(k[item]) && vli_cmp_n(curve_n, k[item]) == 1 &&
+                      EccPoint_isValid(&point[item]);
+        if (!valid[item]) {
+            vli_set(point[item].x, curve_G.x);
+            vli_set(point[item].y, curve_G.y);
+            vli_clear_n(k[item]);
+            k[item][0] = 2;
+        }
+
+        /* k = 1 is k | 1 = 1, and k = n - 1 is k | 1 = n with k even (n is odd). */
+        vli_set_n(tmp1, k[item]);
+        tmp1[0] |= 1;
+        special[item] = (!(k[item][0] & 1) && vli_cmp_n(tmp1, curve_n) == 0) ? 2 : 0;
+        tmp1[0] ^= 1;
+        special[item] = vli_isZero_n(tmp1) ? 1 : special[item];
+
+        /* Regularize the bit count as uECC_sign() does. */
+    #if (uECC_CURVE == uECC_secp160r1)
+        vli_add_n(tmp1, k[item], curve_n);
+        carry = (tmp1[uECC_WORDS] & 0x02);
+        vli_add_n(tmp2, tmp1, curve_n);
+    #else
+        carry = vli_add(tmp1, k[item], curve_n);
+        vli_add(tmp2, tmp1, curve_n);
+    #endif
+        vli_set_n(k[item], k2[!carry]);
+
+        vli_set(Rx[item][1], point[item].x);
+        vli_set(Ry[item][1], point[item].y);
+        XYcZ_initial_double(Rx[item][1], Ry[item][1], Rx[item][0], Ry[item][0], 0);
+    }
+
+    EccPoint_ladder_batch(Rx, Ry, k, count);
+
+    /* Find final 1/Z values. */
+    for (item = 0; item < count; ++item) {
+        nb = !vli_testBit(k[item], 0);
+        vli_modSub_fast(z[item], Rx[item][1], Rx[item][0]);   /* X1 - X0 */
+        vli_modMult_fast(z[item], z[item], Ry[item][1 - nb]); /* Yb * (X1 - X0) */
+        vli_modMult_fast(z[item], z[item], point[item].x);    /* xP * Yb * (X1 - X0) */
+    }
+    vli_modInv_batch(z, count);                               /* 1 / (xP * Yb * (X1 - X0)) */
+
+    for (item = 0; item < count; ++item) {
+        nb = !vli_testBit(k[item], 0);
+        vli_modMult_fast(z[item], z[item], point[item].y);    /* yP / (xP * Yb * (X1 - X0)) */
+        vli_modMult_fast(z[item], z[item], Rx[item][1 - nb]); /* Xb * yP / (xP * Yb * (X1 - X0)) */
+
+        XYcZ_add(Rx[item][nb], Ry[item][nb], Rx[item][1 - nb], Ry[item][1 - nb]);
+        apply_z(Rx[item][0], Ry[item][0], z[item]);
+
+        if (special[item]) {
+            vli_set(Rx[item][0], point[item].x);
+            vli_set(Ry[item][0], point[item].y);
+            if (special[item] == 2) {
+                vli_sub(Ry[item][0], curve_p, point[item].y);
+            }
+        }
+        if (!valid[item]) {
+            vli_clear(Rx[item][0]);
+            vli_clear(Ry[item][0]);
+        }
+        vli_nativeToBytes(results + item * uECC_BYTES * 2, Rx[item][0]);
+        vli_nativeToBytes(results + item * uECC_BYTES * 2 + uECC_BYTES, Ry[item][0]);
+        total += valid[item];
+    }
+    return total;
+}
+
+unsigned uECC_mult_batch(const uint8_t *public_keys,
+                         const uint8_t *scalars,
+                         uint8_t *results,
+                         unsigned count) {
+    unsigned valid = 0;
+    unsigned group;
+
+    while (count) {
+        group = (count < uECC_MULT_BATCH_GROUP ? count : uECC_MULT_BATCH_GROUP);
+        valid += mult_group(public_keys, scalars, results, group);
+        public_keys += group * uECC_BYTES * 2;
+        scalars += group * uECC_BYTES;
+        results += group * uECC_BYTES * 2;
+        count -= group;
+    }
+    return valid;
+}
+
+#endif /* uECC_MULT_BATCH */
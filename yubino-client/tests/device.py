@@ -7,17 +7,53 @@ import ecdsa
 import time
 import secrets
 import logging
+import os
+import subprocess
+import tempfile
 
-DEVICE="/dev/ttyACM0"
+# The suite runs against the board on YUBINO_DEVICE, or against the host emulator
+# (programme/hote/yubino_emulateur, see 'make test-client') if YUBINO_EMULATOR is set
+DEVICE=os.environ.get("YUBINO_DEVICE", "/dev/ttyACM0")
+EMULATOR=os.environ.get("YUBINO_EMULATOR")
 BAUD_RATE=115200
+# Time allowed for the emulator to create its pseudo-terminal
+EMULATOR_START_TIMEOUT=5
 
 class TestDevice(unittest.TestCase):
 
+    @classmethod
+    def setUpClass(cls):
+        cls.port = DEVICE
+        cls.emulator = None
+        if EMULATOR:
+            # Fresh EEPROM image for the whole suite, the button is pressed on every request
+            cls.workdir = tempfile.TemporaryDirectory()
+            cls.port = os.path.join(cls.workdir.name, "tty")
+            cls.emulator = subprocess.Popen(
+                    [EMULATOR, "-e", os.path.join(cls.workdir.name, "eeprom.bin"), "-l", cls.port],
+                    stdout=subprocess.DEVNULL)
+            deadline = time.time() + EMULATOR_START_TIMEOUT
+            while not os.path.exists(cls.port):
+                if time.time() > deadline or cls.emulator.poll() is not None:
+                    raise RuntimeError("Emulator did not start")
+                time.sleep(0.01)
+
+    @classmethod
+    def tearDownClass(cls):
+        if cls.emulator:
+            cls.emulator.terminate()
+            cls.emulator.wait()
+            cls.workdir.cleanup()
+
     def setUp(self):
         logging.disable(logging.CRITICAL)
-        self.device = serial.Serial(port=DEVICE, baudrate=BAUD_RATE, exclusive=True)
-        # Give the mcu some time to restart
-        time.sleep(2)
+        self.device = serial.Serial(port=self.port, baudrate=BAUD_RATE, exclusive=True)
+        if not self.emulator:
+            # Give the mcu some time to restart
+            time.sleep(2)
+
+    def tearDown(self):
+        self.device.close()
 
     def test_reset(self):
         yubino.device.reset(self.device)
@@ -60,6 +96,56 @@ class TestDevice(unittest.TestCase):
         # 5 = STATUS_ERR_STORAGE_FULL
         self.assertEqual(ex.exception.args[0], "Device returned error code 5")
 
+    def test_list_credentials_pages(self):
+        yubino.device.reset(self.device)
+        expected = {}
+        for i in range(5):
+            (credential_id, _) = yubino.device.make_credential(self.device, f"toto {i}")
+            expected[hashlib.sha1(f"toto {i}".encode()).digest()] = credential_id
+
+        cursor = 0
+        entries = []
+        pages = 0
+        while cursor is not None:
+            (page, cursor) = yubino.device.list_credentials_page(self.device, cursor, 2)
+            self.assertLessEqual(len(page), 2)
+            entries += page
+            pages += 1
+        self.assertEqual(pages, 3)
+        self.assertEqual({entry['hashed_app_id']: entry['credential_id'] for entry in entries}, expected)
+        self.assertEqual(entries, yubino.device.list_credentials(self.device))
+
+    def test_list_credentials_prefix(self):
+        yubino.device.reset(self.device)
+        for i in range(5):
+            yubino.device.make_credential(self.device, f"toto {i}")
+        hashed_app_id = hashlib.sha1("toto 3".encode()).digest()
+
+        entries = list(yubino.device.iter_credentials(self.device, 1, hashed_app_id))
+        self.assertEqual([entry['hashed_app_id'] for entry in entries], [hashed_app_id])
+        entries = list(yubino.device.iter_credentials(self.device, prefix=hashed_app_id[:1]))
+        self.assertIn(hashed_app_id, [entry['hashed_app_id'] for entry in entries])
+        for entry in entries:
+            self.assertEqual(entry['hashed_app_id'][:1], hashed_app_id[:1])
+        self.assertEqual(list(yubino.device.iter_credentials(self.device, prefix=bytes(20))), [])
+
+    def test_list_credentials_page_bad_parameter(self):
+        with self.assertRaises(Exception) as ex:
+            yubino.device.list_credentials_page(self.device, 0, 0)
+        # 3 = STATUS_ERR_BAD_PARAMETER
+        self.assertEqual(ex.exception.args[0], "Device returned error code 3")
+
+    def test_list_credentials_page_prefix_too_long(self):
+        self.device.write(struct.pack('BBBB', yubino.device.COMMAND_LIST_PAGE, 0, 1, yubino.device.APP_ID_SIZE + 1))
+        self.device.write(bytes(yubino.device.APP_ID_SIZE + 1))
+        self.device.flush()
+
+        status = struct.unpack('B', self.device.read())[0]
+        # 3 = STATUS_ERR_BAD_PARAMETER
+        self.assertEqual(status, 3)
+        # The whole prefix was read: the next command gets its own answer
+        self.assertEqual(yubino.device.list_credentials(self.device), yubino.device.list_credentials(self.device))
+
     def test_get_assertion_app_unknown(self):
         yubino.device.reset(self.device)
         challenge = secrets.token_hex(64)
@@ -96,6 +182,78 @@ class TestDevice(unittest.TestCase):
         fixed_sig = b'\x00' + signature[:20] + b'\x00' + signature[20:]
         ecdsa_public_key.verify_digest(fixed_sig, yubino.device.get_client_data_hash(challenge, "toto"))
 
+    def test_get_assertions(self):
+        yubino.device.reset(self.device)
+        (credential_id, public_key) = yubino.device.make_credential(self.device, "toto")
+        yubino.device.make_credential(self.device, "tutu")
+        ecdsa_public_key = ecdsa.VerifyingKey.from_string(
+                public_key,
+                curve=ecdsa.SECP160r1)
+
+        for count in (1, yubino.device.ASSERTIONS_MAX):
+            challenges = [secrets.token_hex(64) for i in range(count)]
+            (used_credential_id, signatures) = yubino.device.get_assertions(self.device, "toto", challenges)
+
+            self.assertEqual(credential_id, used_credential_id)
+            self.assertEqual(len(signatures), count)
+            for (challenge, signature) in zip(challenges, signatures):
+                fixed_sig = b'\x00' + signature[:20] + b'\x00' + signature[20:]
+                ecdsa_public_key.verify_digest(fixed_sig, yubino.device.get_client_data_hash(challenge, "toto"))
+
+    def test_get_assertions_app_unknown(self):
+        yubino.device.reset(self.device)
+        with self.assertRaises(Exception) as ex:
+            yubino.device.get_assertions(self.device, "toto", [secrets.token_hex(64), secrets.token_hex(64)])
+        # 4 = STATUS_ERR_NOT_FOUND
+        self.assertEqual(ex.exception.args[0], "Device returned error code 4")
+
+    def test_get_assertions_bad_parameter(self):
+        self.device.write(struct.pack('B', yubino.device.COMMAND_GET_ASSERTIONS))
+        self.device.write(bytes(yubino.device.APP_ID_SIZE))
+        self.device.write(struct.pack('B', yubino.device.ASSERTIONS_MAX + 1))
+        self.device.write(bytes((yubino.device.ASSERTIONS_MAX + 1) * 20))
+        self.device.flush()
+
+        status = struct.unpack('B', self.device.read())[0]
+        # 3 = STATUS_ERR_BAD_PARAMETER
+        self.assertEqual(status, 3)
+        # The whole request was read: the next command gets its own answer
+        self.assertEqual(yubino.device.list_credentials(self.device), yubino.device.list_credentials(self.device))
+
+    def test_set_baud(self):
+        for baud in yubino.device.BAUD_RATES[1:]:
+            self.assertTrue(yubino.device.set_baud(self.device, baud))
+            yubino.device.reset(self.device)
+            yubino.device.make_credential(self.device, "toto")
+            entries = yubino.device.list_credentials(self.device)
+            self.assertEqual(len(entries), 1)
+            self.assertTrue(yubino.device.set_baud(self.device, yubino.device.DEFAULT_BAUD))
+
+    def test_set_baud_final_ok_lost(self):
+        # The client missed the second STATUS_OK and went back to 115200: its next byte is
+        # garbled at the new speed, the device must drop it silently and fall back too
+        self.device.write(struct.pack('BB', yubino.device.COMMAND_SET_BAUD, 1))
+        self.device.flush()
+        self.assertEqual(self.device.read(), bytes([yubino.device.STATUS_OK]))
+        self.device.write(struct.pack('B', yubino.device.BAUD_CONFIRMATION))
+        self.device.flush()
+        self.assertEqual(self.device.read(), bytes([yubino.device.STATUS_OK]))
+        self.device.write(b'\xff')
+        self.device.flush()
+        self.device.timeout = yubino.device.BAUD_CONFIRMATION_DELAY
+        self.assertEqual(self.device.read(), b'')
+        self.device.timeout = None
+        yubino.device.reset(self.device)
+        self.assertEqual(len(yubino.device.list_credentials(self.device)), 0)
+
+    def test_set_baud_bad_parameter(self):
+        self.device.write(struct.pack('BB', yubino.device.COMMAND_SET_BAUD, 100))
+        self.device.flush()
+
+        status = struct.unpack('B', self.device.read())[0]
+        # 3 = STATUS_ERR_BAD_PARAMETER
+        self.assertEqual(status, 3)
+
     def test_bad_command(self):
         self.device.write(struct.pack('B', 100))
         self.device.flush()
@@ -1,20 +1,42 @@
 import struct
 import hashlib
 import logging
+import time
+import serial
 
 COMMAND_LIST_CREDENTIALS = 0
 COMMAND_MAKE_CREDENTIAL = 1
 COMMAND_GET_ASSERTION = 2
 COMMAND_RESET = 3
+COMMAND_SET_BAUD = 4
+COMMAND_LIST_PAGE = 5
+COMMAND_GET_ASSERTIONS = 6
 
 STATUS_OK = 0
 STATUS_ERR_COMMAND_UNKNOWN = 1
+STATUS_ERR_BAD_PARAMETER = 3
 
 CREDENTIAL_ID_SIZE = 16
 PUBLIC_KEY_SIZE = 40
 APP_ID_SIZE = 20
 SIGNATURE_SIZE = 40
 
+# LIST_PAGE: the device caps the page size to LIST_PAGE_MAX entries, and answers
+# LIST_END as next cursor when no entry is left
+LIST_PAGE_MAX = 8
+LIST_END = 0xFF
+
+# GET_ASSERTIONS: maximum number of challenges signed under one confirmation
+ASSERTIONS_MAX = 4
+
+# Link speeds known by the device: the index in this list is the code sent with SET_BAUD.
+# The device always boots at DEFAULT_BAUD.
+DEFAULT_BAUD = 115200
+BAUD_RATES = [DEFAULT_BAUD, 250000, 500000, 1000000, 2000000]
+BAUD_CONFIRMATION = 0xA5
+# The device falls back to DEFAULT_BAUD if it does not get the confirmation within 500 ms
+BAUD_CONFIRMATION_DELAY = 0.5
+
 def reset(device):
     """
     Send a RESET command to the device
@@ -93,18 +115,70 @@ def list_credentials(device):
     count = struct.unpack('B', device.read())[0]
     logging.debug("%d entries to retrieve", count)
 
-    entries = []
-    for i in range(count):
-        logging.debug("Retrieve credential %d", i)
-        credential_id = device.read(CREDENTIAL_ID_SIZE)
-        logging.debug("credential_id = %s", credential_id.hex())
+    return read_entries(device, count)
 
-        app_id = device.read(APP_ID_SIZE)
-        logging.debug("hashed_app_id = %s", app_id.hex())
+def read_entries(device, count):
+    """
+    Read <count> (credential_id, hashed_app_id) entries of a LIST_CREDENTIALS or
+    LIST_PAGE response, in a single read
+    """
+    entry_size = CREDENTIAL_ID_SIZE + APP_ID_SIZE
+    data = device.read(count * entry_size)
 
+    entries = []
+    for i in range(count):
+        entry = data[i * entry_size:(i + 1) * entry_size]
+        credential_id = entry[:CREDENTIAL_ID_SIZE]
+        app_id = entry[CREDENTIAL_ID_SIZE:]
+        logging.debug("credential %d: credential_id = %s, hashed_app_id = %s", i, credential_id.hex(), app_id.hex())
         entries.append({'hashed_app_id': app_id, 'credential_id': credential_id})
     return entries
 
+def list_credentials_page(device, cursor=0, page_size=LIST_PAGE_MAX, prefix=b''):
+    """
+    Send a LIST_PAGE command to the device
+
+    :param <cursor>: 0 for the first page, then the cursor returned with the previous page
+    :param <page_size>: maximum number of entries to return (the device caps it to LIST_PAGE_MAX)
+    :param <prefix>: only return entries whose hashed app_id starts with these bytes (at most APP_ID_SIZE)
+
+    :except Exception: if the device returns an error
+
+    :return (<entries>, <next_cursor>), where
+    - <entries> is a list of {'hashed_app_id': ..., 'credential_id': ...} as in list_credentials()
+    - <next_cursor> is the cursor of the next page, or None if there is none
+    """
+    if len(prefix) > APP_ID_SIZE:
+        raise ValueError(f"Prefix longer than {APP_ID_SIZE} bytes")
+    logging.info("Sending LIST_PAGE command with cursor=%d, page_size=%d and prefix=%s",
+                 cursor, page_size, prefix.hex())
+    device.write(struct.pack('BBBB', COMMAND_LIST_PAGE, cursor, page_size, len(prefix)))
+    device.write(prefix)
+    device.flush()
+
+    status = struct.unpack('B', device.read())[0]
+    logging.debug("Received status code %d", status)
+    if status != STATUS_OK:
+        logging.error("Something bad happened: error code %d", status)
+        raise Exception(f"Device returned error code {status}")
+
+    (count, next_cursor) = struct.unpack('BB', device.read(2))
+    logging.debug("%d entries to retrieve, next cursor %d", count, next_cursor)
+
+    entries = read_entries(device, count)
+    return (entries, None if next_cursor == LIST_END else next_cursor)
+
+def iter_credentials(device, page_size=LIST_PAGE_MAX, prefix=b''):
+    """
+    Iterate over the credentials of the device whose hashed app_id starts with
+    <prefix>, fetching them page by page with LIST_PAGE (one command per page,
+    only when the previous page has been consumed)
+    """
+    cursor = 0
+    while cursor is not None:
+        (entries, cursor) = list_credentials_page(device, cursor, page_size, prefix)
+        yield from entries
+
 
 def get_client_data_hash(challenge, app_id):
     return hashlib.sha1(("challenge=%s&app_id=%s" % (challenge, app_id)).encode()).digest()
@@ -153,3 +227,138 @@ def get_assertion(device, app_id, challenge):
     logging.debug("signature = %s", signature.hex())
 
     return (credential_id, signature)
+
+def get_assertions(device, app_id, challenges):
+    """
+    Send a GET_ASSERTIONS command to the device: sign the clientDataHash of each
+    challenge with the key of <app_id>, under a single user confirmation
+
+    :param <app_id>: raw app_id given by the Relying Party
+    :param <challenges>: 1 to ASSERTIONS_MAX raw challenges, valid hexadecimal strings
+
+    :except Exception: if the device returns an error
+
+    :return (<credential_id: bytes>, <signatures: List[bytes]>) where
+    - <credential_id> is the identifier of the key pair used to compute the signatures
+    - <signatures> are the signatures of the clientDataHash, in the order of <challenges>
+    """
+    if not 1 <= len(challenges) <= ASSERTIONS_MAX:
+        raise ValueError(f"Between 1 and {ASSERTIONS_MAX} challenges per batch")
+    hashed_app_id = hashlib.sha1(app_id.encode()).digest()
+    logging.info("Sending GET_ASSERTIONS command with hashed_app_id=%s and %d challenges",
+                 hashed_app_id.hex(), len(challenges))
+    for challenge in challenges:
+        try:
+            bytes.fromhex(challenge)
+        except Exception as e:
+            logging.error("Failed to convert challenge to bytes: %s", e)
+            raise
+
+    device.write(struct.pack('B', COMMAND_GET_ASSERTIONS))
+    device.write(hashed_app_id)
+    device.write(struct.pack('B', len(challenges)))
+    for challenge in challenges:
+        device.write(get_client_data_hash(challenge, app_id))
+    device.flush()
+
+    status = struct.unpack('B', device.read())[0]
+    logging.debug("Received status code %d", status)
+    if status != STATUS_OK:
+        logging.error("Something bad happenned: error code %d", status)
+        raise Exception(f"Device returned error code {status}")
+
+    logging.debug("Retrieve credential_id")
+    credential_id = device.read(CREDENTIAL_ID_SIZE)
+    logging.debug("credential_id = %s", credential_id.hex())
+
+    logging.debug("Retrieve %d signatures", len(challenges))
+    data = device.read(len(challenges) * SIGNATURE_SIZE)
+    signatures = [data[i:i + SIGNATURE_SIZE] for i in range(0, len(data), SIGNATURE_SIZE)]
+    for signature in signatures:
+        logging.debug("signature = %s", signature.hex())
+
+    return (credential_id, signatures)
+
+
+def _back_to_default_baud(device):
+    """
+    Switch the client to DEFAULT_BAUD and wait until the device, missing the
+    confirmation byte, has fallen back as well
+    """
+    device.baudrate = DEFAULT_BAUD
+    time.sleep(BAUD_CONFIRMATION_DELAY + 0.1)
+    device.reset_input_buffer()
+
+def set_baud(device, baud):
+    """
+    Send a SET_BAUD command to the device and switch the link to <baud>
+
+    Both ends switch speed after the first STATUS_OK, then the client sends a
+    confirmation byte at the new speed and the device answers a second STATUS_OK.
+    The client acknowledges that one with the confirmation byte again: until the
+    device gets a valid byte at the new speed, it goes back to DEFAULT_BAUD after
+    BAUD_CONFIRMATION_DELAY. Whenever a STATUS_OK is missing, the client goes back
+    to DEFAULT_BAUD too, and waits until the device has done the same.
+
+    :return True if the link now runs at <baud>, False if it runs at DEFAULT_BAUD
+    """
+    if baud not in BAUD_RATES:
+        raise ValueError(f"Unsupported baud rate {baud}")
+    logging.info("Sending SET_BAUD command with baud=%d", baud)
+
+    timeout = device.timeout
+    device.timeout = BAUD_CONFIRMATION_DELAY
+    try:
+        device.write(struct.pack('BB', COMMAND_SET_BAUD, BAUD_RATES.index(baud)))
+        device.flush()
+
+        status = device.read()
+        if len(status) == 1 and status[0] == STATUS_ERR_BAD_PARAMETER:
+            logging.error("Device refused baud rate %d", baud)
+            return False
+        if len(status) != 1 or status[0] != STATUS_OK:
+            # The device may have switched anyway: wait for it to come back
+            logging.warning("No answer to SET_BAUD %d: %s, staying at %d", baud, status.hex(), DEFAULT_BAUD)
+            _back_to_default_baud(device)
+            return False
+
+        device.baudrate = baud
+        device.write(struct.pack('B', BAUD_CONFIRMATION))
+        device.flush()
+
+        status = device.read()
+        if len(status) == 1 and status[0] == STATUS_OK:
+            # Final acknowledgement, so that the device keeps the new speed
+            device.write(struct.pack('B', BAUD_CONFIRMATION))
+            device.flush()
+            logging.debug("Link now running at %d bauds", baud)
+            return True
+
+        logging.warning("No confirmation at %d bauds, back to %d", baud, DEFAULT_BAUD)
+        _back_to_default_baud(device)
+        return False
+    finally:
+        device.timeout = timeout
+
+def negotiate_baud(device, max_baud=BAUD_RATES[-1]):
+    """
+    Switch the link to the fastest speed up to <max_baud> that works with this device
+
+    :return the baud rate in use
+    """
+    for baud in sorted(BAUD_RATES, reverse=True):
+        if baud > max_baud or baud == DEFAULT_BAUD:
+            continue
+        if set_baud(device, baud):
+            return baud
+    return DEFAULT_BAUD
+
+def connect(port, max_baud=BAUD_RATES[-1]):
+    """
+    Open the serial link with the device at DEFAULT_BAUD, then negotiate a faster
+    speed up to <max_baud> (no negotiation if <max_baud> is DEFAULT_BAUD)
+    """
+    device = serial.Serial(port=port, baudrate=DEFAULT_BAUD, exclusive=True)
+    if max_baud > DEFAULT_BAUD:
+        negotiate_baud(device, max_baud)
+    return device
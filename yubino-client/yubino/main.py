@@ -6,8 +6,8 @@ def main() -> int:
     parser = argparse.ArgumentParser()
     parser.add_argument("-d", "--device", type=str, default="/dev/ttyACM0",
                         help="Connect to the given device, defaults to '/dev/ttyACM0'")
-    parser.add_argument("-b", "--baud", help="Baud rate, defaults to 115200",
-                        type=int, default=115200)
+    parser.add_argument("-b", "--baud", help="Highest baud rate negotiated with the device, defaults to 1000000 "
+                        "(115200 disables the negotiation)", type=int, default=1000000)
     parser.add_argument("-r", "--relying-party", default="http://localhost:8000", type=str,
                         help="Relying party to connect to, defaults to 'http://localhost:8000'")
     parser.add_argument("--list-devices", help="List available serial devices", action="store_true")
@@ -18,7 +18,8 @@ class YubinoShell(cmd.Cmd):
 
     def preloop(self):
         logging.info("Connect to device %s", self.config.device)
-        self.device = serial.Serial(port=self.config.device, baudrate=self.config.baud, exclusive=True)
+        self.device = yubino.device.connect(self.config.device, self.config.baud)
+        logging.info("Link speed: %d bauds", self.device.baudrate)
         self.http_client = yubino.web.Client(self.config, self.device)
 
     def do_index(self, arg):
@@ -106,10 +107,18 @@ class YubinoShell(cmd.Cmd):
 
     def do_device_list_credentials(self, arg):
         """
-        List the credentials of the device
+        List the credentials of the device, page by page. With <prefix> (hexadecimal),
+        only those whose hashed app_id starts with it.
+        device_list_credentials [<prefix>]
         """
         try:
-            for entry in yubino.device.list_credentials(self.device):
+            prefix = bytes.fromhex(arg.strip())
+        except ValueError:
+            print("Usage: device_list_credentials [<prefix>]")
+            return
+
+        try:
+            for entry in yubino.device.iter_credentials(self.device, prefix=prefix):
                 print("hashed_app_id: %s - credential_id: %s" % (entry['hashed_app_id'].hex(), entry['credential_id'].hex()))
         except Exception as e:
             print("Operation failed: %s" % e)